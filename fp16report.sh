@@ -0,0 +1,117 @@
+#!/bin/bash
+# fp16report.sh
+# Author:        Agner Fog
+# Date created:  2026-10-19
+# Last modified: 2026-10-19
+#
+# This script makes a report of the speed of half precision vector functions
+# of the C++ Vector Class Library with emulated and native half precision.
+# The input is the benchmark file written by testbench4.cpp with BENCHMARK defined,
+# for example by running test4bench.lst. Each line of the report is a test case
+# and vector type. Each column is an instruction set showing clock cycles per element.
+# Clock counts marked with '*' are from runs in the emulator and are not valid.
+# The last column is the speedup of native half precision (AVX512-FP16) relative to
+# the fastest instruction set with emulated half precision.
+# If the same combination has been run more than once, the last result is used.
+#
+# (c) Copyright 2026 by Agner Fog.
+# GNU General Public License 3.0 or later www.gnu.org/licenses
+#
+###############################################################################
+#
+# Instructions:
+# ./fp16report.sh [benchfile [testbench]]
+#
+# Example:
+# ./runtest.sh test4bench.lst
+# ./fp16report.sh bench4.csv ../testbench4/testbench4.cpp
+#
+# benchfile  benchmark results. Default bench4.csv
+# testbench  testbench4.cpp. Used only for getting function names from the
+#            list of test cases. Default testbench4.cpp
+###############################################################################
+
+benchfile=${1:-bench4.csv}
+testbench=${2:-testbench4.cpp}
+
+if [ ! -e "$benchfile" ] ; then
+  echo "Error: file $benchfile not found"
+  exit 99
+fi
+if [ ! -e "$testbench" ] ; then
+  testbench=/dev/null            # function names not available
+fi
+
+# first file: function names from the list of test cases in testbench4.cpp
+# second file: benchmark results
+tr -d '\r' < "$testbench" | awk -F, '
+  FILENAME == "-" {
+    if (match($0, /^[0-9]+: +/)) {
+      name = substr($0, RLENGTH + 1)
+      sub(/ *(\(|\/\/).*/, "", name)
+      sub(/ +$/, "", name)
+      funcname[substr($0, 1, index($0, ":") - 1)] = name
+    }
+    next
+  }
+  $1 == "testcase" { next }      # header line
+  NF >= 7 {
+    key = $1 SUBSEP $2 SUBSEP $3
+    if (!(key in seen)) {
+      seen[key] = 1
+      keys[++numkeys] = key
+    }
+    if (!($4 in isets)) {
+      isets[$4] = 1
+      isetlist[++numisets] = $4 + 0
+    }
+    emulated = ($7 == 1)
+    cell[key, $4] = sprintf("%.3g%s", $6, emulated ? "*" : "")
+    delete clocks[key, $4]
+    if (!emulated) {
+      clocks[key, $4] = $6 + 0
+      native[key, $4] = $5 + 0
+    }
+  }
+  END {
+    if (numkeys == 0) {
+      print "No benchmark results found"
+      exit 1
+    }
+    # sort instruction sets
+    for (i = 1; i <= numisets; i++) {
+      for (j = i + 1; j <= numisets; j++) {
+        if (isetlist[j] < isetlist[i]) {
+          t = isetlist[i];  isetlist[i] = isetlist[j];  isetlist[j] = t
+        }
+      }
+    }
+    print "Clock cycles per element for each instruction set"
+    print "* = emulated. Clock cycles are not valid"
+    print "speedup = fastest emulated half precision / native half precision\n"
+    printf("%-5s %-20s %-7s %-8s", "case", "function", "vtype", "rtype")
+    for (i = 1; i <= numisets; i++) printf(" %-11s", "INSTRSET " isetlist[i])
+    printf(" %s\n", "speedup")
+    for (k = 1; k <= numkeys; k++) {
+      split(keys[k], f, SUBSEP)
+      name = (f[1] in funcname) ? funcname[f[1]] : "?"
+      printf("%-5s %-20s %-7s %-8s", f[1], name, f[2], f[3])
+      bestemulated = 0;  bestnative = 0
+      for (i = 1; i <= numisets; i++) {
+        is = isetlist[i]
+        c = ((keys[k], is) in cell) ? cell[keys[k], is] : "-"
+        printf(" %-11s", c)
+        if ((keys[k], is) in clocks) {
+          t = clocks[keys[k], is]
+          if (native[keys[k], is]) {
+            if (bestnative == 0 || t < bestnative) bestnative = t
+          }
+          else {
+            if (bestemulated == 0 || t < bestemulated) bestemulated = t
+          }
+        }
+      }
+      if (bestemulated > 0 && bestnative > 0) printf(" %.2f\n", bestemulated / bestnative)
+      else printf(" -\n")
+    }
+  }' - "$benchfile"
@@ -0,0 +1,232 @@
+#!/bin/bash
+# fuzzpermute.sh
+# Author:        Agner Fog
+# Date created:  2026-10-19
+# Last modified: 2026-10-19
+#
+# This script tests permute and blend functions of the C++ Vector Class Library
+# with random index patterns. The patterns are generated in batches of a few
+# hundred and compiled into testbench2.cpp as test case 14 (permute) or
+# 15 (blend). The batches are compiled and run in parallel.
+# Failing patterns are appended to a list file in the format of test2.lst
+# so that they can be repeated with runtest.sh.
+#
+# (c) Copyright 2026 by Agner Fog.
+# GNU General Public License 3.0 or later www.gnu.org/licenses
+#
+###############################################################################
+#
+# Instructions:
+# ./fuzzpermute.sh vtype funcname instrset [numbatches [batchsize [seed]]]
+#
+# Example: 100 batches of 300 patterns for permute16 on Vec16f with AVX512:
+# ./fuzzpermute.sh Vec16f permute16 10 100 300
+#
+# The following settings can be changed by environment variables with the same name:
+# include    directory of VCL .h include files
+# testbench  path of testbench2.cpp
+# compiler   g++ or clang++
+# jobs       number of batches to compile and run in parallel
+# workdir    directory for generated files
+# failfile   list file for failing patterns
+# emulator   path of Intel emulator, if instrset not supported by the CPU
+#
+# Probabilities for random patterns, in percent:
+# pzero      probability that an index is -1 (set to zero)
+# pdontcare  probability that an index is V_DC (don't care)
+# plane      probability that a pattern is lane-local (no crossing of 128-bit lanes)
+# pbroadcast probability that a pattern is a broadcast of one element
+#
+# Generated files are deleted when a batch succeeds. Files of failing
+# batches are kept in workdir until the next run. failfile is cleared at
+# the start of each run.
+###############################################################################
+
+include=${include:-../src2}
+testbench=${testbench:-testbench2.cpp}
+compiler=${compiler:-g++}
+jobs=${jobs:-`nproc 2>/dev/null || echo 4`}
+workdir=${workdir:-fuzzwork}
+failfile=${failfile:-fuzzfail.lst}
+emulator=${emulator:-}
+
+pzero=${pzero:-5}
+pdontcare=${pdontcare:-5}
+plane=${plane:-25}
+pbroadcast=${pbroadcast:-10}
+
+# command line parameters
+vtype=$1
+funcname=$2
+instrset=$3
+numbatches=${4:-10}
+batchsize=${5:-300}
+seed=${6:-1}
+
+if [[ -z "$vtype" || -z "$funcname" || -z "$instrset" ]] ; then
+  echo "Use: ./fuzzpermute.sh vtype funcname instrset [numbatches [batchsize [seed]]]"
+  exit 99
+fi
+
+# get vector size and element size from vector type name
+if [[ $vtype =~ ^Vec([0-9]+)(u?)([csiqfdh])$ ]] ; then
+  vectorsize=${BASH_REMATCH[1]}
+  case ${BASH_REMATCH[3]} in
+    c)       elementsize=1 ;;
+    s | h)   elementsize=2 ;;
+    i | f)   elementsize=4 ;;
+    q | d)   elementsize=8 ;;
+  esac
+else
+  echo "Error: unknown vector type $vtype"
+  exit 98
+fi
+
+# number of elements in a 128-bit lane
+lanesize=$((16 / elementsize))
+if [[ $lanesize -gt $vectorsize ]] ; then
+  lanesize=$vectorsize
+fi
+
+# permute or blend
+if [[ $funcname == blend* ]] ; then
+  testcase=15
+  lstcase=2
+  blend=1
+else
+  testcase=14
+  lstcase=1
+  blend=0
+fi
+
+# instruction set options
+if [[ $instrset -lt 3 ]] ; then
+  isetoption=-msse2
+elif [[ $instrset -eq 3 ]] ; then
+  isetoption=-msse3
+elif [[ $instrset -eq 4 ]] ; then
+  isetoption=-mssse3
+elif [[ $instrset -eq 5 ]] ; then
+  isetoption=-msse4.1
+elif [[ $instrset -eq 6 ]] ; then
+  isetoption=-msse4.2
+elif [[ $instrset -eq 7 ]] ; then
+  isetoption=-mavx
+elif [[ $instrset -eq 8 ]] ; then
+  isetoption="-mfma -mavx2 -mf16c "
+elif [[ $instrset -eq 9 ]] ; then
+  isetoption="-mfma -mavx512f -mf16c "
+elif [[ $instrset -eq 10 ]] ; then
+  isetoption="-mfma -mavx512bw -mavx512dq -mavx512vl -mf16c "
+elif [[ $instrset -eq 11 ]] ; then
+  isetoption="-mfma -mavx512bw -mavx512dq -mavx512vl -mf16c -mavx512vbmi -mavx512vbmi2 "
+elif [[ $instrset -eq 12 ]] ; then
+  isetoption="-mfma -mavx512bw -mavx512dq -mavx512vl -mf16c -mavx512vbmi -mavx512vbmi2 -mavx512fp16 "
+fi
+
+
+# Function to write a batch of random index patterns
+# Parameter: random number seed
+makePatterns() {
+  awk -v n=$vectorsize -v lanesize=$lanesize -v blend=$blend -v count=$batchsize -v seed=$1 \
+      -v pzero=$pzero -v pdontcare=$pdontcare -v plane=$plane -v pbroadcast=$pbroadcast '
+  BEGIN {
+    srand(seed)
+    range = blend ? 2 * n : n                   # index range
+    printf("// Generated by fuzzpermute.sh, seed %i\n", seed)
+    for (p = 0; p < count; p++) {
+      # choose pattern structure
+      u = rand() * 100
+      if (u < pbroadcast) kind = 1              # broadcast
+      else if (u < pbroadcast + plane) kind = 2 # lane-local
+      else kind = 0                             # unstructured
+      b = int(rand() * range)                   # broadcast index
+      samelanes = rand() < 0.5                  # lane-local: same pattern in all lanes
+      line = "PATTERN("
+      for (j = 0; j < n; j++) {
+        k = j % lanesize                        # position within lane
+        if (kind == 1) {
+          i = b
+        }
+        else if (kind == 2) {
+          if (!samelanes || j < lanesize) {
+            r[k] = int(rand() * lanesize)       # position within lane
+            src[k] = (blend && rand() < 0.5) ? n : 0  # from a or b
+          }
+          i = src[k] + j - k + r[k]
+        }
+        else {
+          i = int(rand() * range)
+        }
+        u = rand() * 100
+        if (u < pzero) i = -1
+        else if (u < pzero + pdontcare) i = "V_DC"
+        line = line (j > 0 ? "," : "") i
+      }
+      print line ")"
+    }
+  }'
+}
+
+
+# Function to generate, compile and run one batch
+# Parameter: batch number
+runBatch() {
+  batch=$1
+  batchseed=$((seed * 100003 + batch))
+  header="batch$batch.h"
+  exe="$workdir/batch$batch"
+  out="$workdir/batch$batch.txt"
+  makePatterns $batchseed > "$workdir/$header"
+
+  $compiler -std=c++17 -O2 -fno-trapping-math $isetoption -I$include -I$workdir \
+    -Dtestcase=$testcase -Dvtype=$vtype -Dfuncname=$funcname -DINSTRSET=$instrset \
+    -Dseed=$batchseed "-DPATTERNFILE=\"$header\"" -o$exe $testbench > $out 2>&1
+  if [ $? -ne 0 ] ; then
+    echo "*** batch $batch: compiling failed. See $out"
+    echo "# batch $batch: compiling failed. See $out" >> $failfile
+    return 1
+  fi
+
+  if [ -n "$emulator" ] ; then
+    $emulator -future -- ./$exe >> $out
+  else
+    ./$exe >> $out
+  fi
+  if [ $? -ne 0 ] ; then
+    echo "*** batch $batch: test failed. See $out"
+    # write failing patterns as test list lines
+    grep "failing pattern:" $out | sed "s/failing pattern: *//" | \
+      while read -r pattern ; do
+        echo "$lstcase , $vtype , , $instrset , $funcname , $pattern" >> $failfile
+      done
+    return 1
+  fi
+  rm -f $exe $out "$workdir/$header"
+  return 0
+}
+
+
+mkdir -p $workdir
+rm -f $workdir/batch*                  # remove files from previous run
+: > $failfile                          # clear list of failing patterns
+starttime=`date +%s`
+echo "Fuzz test of $funcname, $vtype, instruction set $instrset: $numbatches batches of $batchsize patterns"
+
+# run batches in parallel, max $jobs at a time
+for ((batch = 0; batch < numbatches; batch++)) ; do
+  while [[ `jobs -r | wc -l` -ge $jobs ]] ; do
+    wait -n
+  done
+  runBatch $batch &
+done
+wait
+
+endtime=`date +%s`
+elapsedtime=$(($endtime - $starttime))
+failures=`ls $workdir/batch*.txt 2>/dev/null | wc -l`
+echo "$((numbatches * batchsize)) patterns tested in $elapsedtime seconds. $failures batches failed"
+if [[ $failures -gt 0 ]] ; then
+  echo "Failing patterns are written to $failfile"
+  exit 1
+fi
@@ -0,0 +1,104 @@
+#!/bin/bash
+# isareport.sh
+# Author:        Agner Fog
+# Date created:  2026-10-19
+# Last modified: 2026-10-19
+#
+# This script makes a report of the accuracy and speed of mathematical functions
+# of the C++ Vector Class Library for each instruction set, side by side.
+# The input is the benchmark file written by testbench3.cpp with BENCHMARK defined,
+# for example by running test3isa.lst. Each line of the report is a test case,
+# vector type, library, and test data. Each column is an instruction set showing
+# max ULP / mean ULP / clock cycles per element.
+# Clock counts marked with '*' are from runs in the emulator and are not valid.
+# The last column is the instruction set with the fewest clock cycles.
+# If the same combination has been run more than once, the last result is used.
+#
+# (c) Copyright 2026 by Agner Fog.
+# GNU General Public License 3.0 or later www.gnu.org/licenses
+#
+###############################################################################
+#
+# Instructions:
+# ./isareport.sh [benchfile [testbench]]
+#
+# Example:
+# ./runtest.sh test3isa.lst
+# ./isareport.sh bench3.csv ../testbench3/testbench3.cpp
+#
+# benchfile  benchmark results. Default bench3.csv
+# testbench  testbench3.cpp. Used only for getting function names from the
+#            list of test cases. Default testbench3.cpp
+###############################################################################
+
+benchfile=${1:-bench3.csv}
+testbench=${2:-testbench3.cpp}
+
+if [ ! -e "$benchfile" ] ; then
+  echo "Error: file $benchfile not found"
+  exit 99
+fi
+if [ ! -e "$testbench" ] ; then
+  testbench=/dev/null            # function names not available
+fi
+
+# first file: function names from the list of test cases in testbench3.cpp
+# second file: benchmark results
+tr -d '\r' < "$testbench" | awk -F, '
+  FILENAME == "-" {
+    if (match($0, /^[0-9]+: +/)) {
+      name = substr($0, RLENGTH + 1)
+      sub(/[ ,(].*/, "", name)
+      funcname[substr($0, 1, index($0, ":") - 1)] = name
+    }
+    next
+  }
+  $1 == "testcase" { next }      # header line
+  NF >= 11 {
+    key = $1 SUBSEP $2 SUBSEP $5 SUBSEP $6
+    if (!(key in seen)) {
+      seen[key] = 1
+      keys[++numkeys] = key
+    }
+    if (!($3 in isets)) {
+      isets[$3] = 1
+      isetlist[++numisets] = $3 + 0
+    }
+    emulated = (NF >= 12 && $12 == 1)
+    cell[key, $3] = sprintf("%.3g/%.3g/%.3g%s", $10, $11, $7, emulated ? "*" : "")
+    if (!emulated) clocks[key, $3] = $7 + 0
+  }
+  END {
+    if (numkeys == 0) {
+      print "No benchmark results found"
+      exit 1
+    }
+    # sort instruction sets
+    for (i = 1; i <= numisets; i++) {
+      for (j = i + 1; j <= numisets; j++) {
+        if (isetlist[j] < isetlist[i]) {
+          t = isetlist[i];  isetlist[i] = isetlist[j];  isetlist[j] = t
+        }
+      }
+    }
+    print "Accuracy and speed for each instruction set: max ULP / mean ULP / clock cycles per element"
+    print "* = emulated. Clock cycles are not valid\n"
+    printf("%-5s %-12s %-7s %-8s %-9s", "case", "function", "vtype", "library", "data")
+    for (i = 1; i <= numisets; i++) printf(" %-20s", "INSTRSET " isetlist[i])
+    printf(" %s\n", "fastest")
+    for (k = 1; k <= numkeys; k++) {
+      split(keys[k], f, SUBSEP)
+      name = (f[1] in funcname) ? funcname[f[1]] : "?"
+      printf("%-5s %-12s %-7s %-8s %-9s", f[1], name, f[2], f[3], f[4])
+      best = "";  bestclocks = 0
+      for (i = 1; i <= numisets; i++) {
+        is = isetlist[i]
+        c = ((keys[k], is) in cell) ? cell[keys[k], is] : "-"
+        printf(" %-20s", c)
+        if (((keys[k], is) in clocks) && (best == "" || clocks[keys[k], is] < bestclocks)) {
+          best = is;  bestclocks = clocks[keys[k], is]
+        }
+      }
+      printf(" %s\n", best == "" ? "-" : best)
+    }
+  }' - "$benchfile"
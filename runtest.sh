@@ -2,7 +2,7 @@
 # runtest.sh
 # Author:        Agner Fog
 # Date created:  2019-06-02
-# Last modified: 2026-04-10
+# Last modified: 2026-10-19
 # 
 # This script will compile and run a testbench for the C++ Vector Class Library
 # Using a list of test cases.
@@ -45,8 +45,14 @@
 # $outfile= (name of output file)
 # $include= (directory of .h include files. May be relative path)
 # $emulator= (path and name of Intel emulator, to be called if instruction set not supported by current CPU)
+#             The macro EMULATED is defined for the testbench when the emulator is used
 # $compilermax= (maximum instruction set supported by the compiler. skip test cases with higher instruction set)
 # $seed= (an integer for initializing random number generator)
+# $arguments= (command line arguments for the compiled test program, separated by '+'. 
+#             Blank for none. Example for testbench2: $arguments=1000000+8 gives 1000000 test
+#             runs in each of 8 threads)
+# $define= (extra macros to define for the testbench, separated by '+'. Blank for none.
+#             Example: $define=EXHAUSTIVE_TEST+EXPONENT_MIN=-10)
 #
 # Comments begin with '#'
 #
@@ -119,8 +125,23 @@ compileAndRun() {
     parf=""
   fi
   
+  # extra defines, separated by '+'
+  if [[ -z "$defines" ]] ; then
+    pardef=""
+    pardefms=""
+  else
+    pardef="-D${defines//\+/ -D}"
+    pardefms="/D ${defines//\+/ /D }"
+  fi
+
+  # tell the testbench that it runs in the emulator. Clock counts are not valid then
+  if [[ -n "$maxiset" && $instrset -gt $maxiset ]] ; then
+    pardef="$pardef -DEMULATED"
+    pardefms="$pardefms /D EMULATED"
+  fi
+
   # compiler parameters
-  parameters="-Dtestcase=$testcase $parf -Dvtype=$vtype -Drtype=$rtype -DINSTRSET=$instrset -Dseed=$seed"
+  parameters="-Dtestcase=$testcase $parf -Dvtype=$vtype -Drtype=$rtype -DINSTRSET=$instrset -Dseed=$seed $pardef"
 
   # indexes for template functions
   if [[ -z "$indexes" ]] ; then
@@ -197,7 +218,7 @@ compileAndRun() {
       elif [[ $instrset -eq 10 ]] ; then
         isetoption=/arch:AVX512
       fi
-      parameters="/D testcase=$testcase /D vtype=$vtype /D rtype=$rtype /D INSTRSET=$instrset /D funcname=$funcname"
+      parameters="/D testcase=$testcase /D vtype=$vtype /D rtype=$rtype /D INSTRSET=$instrset /D funcname=$funcname $pardefms"
       echo cl.exe "$options $parameters /I$include $testbench $isetoption /D indexes=$inx2 $extraoptions $testbench $extrasource"
       eval cl.exe "$options $parameters /I$include $testbench $isetoption /D indexes=$inx2 $extraoptions $testbench $extrasource"
       
@@ -223,7 +244,7 @@ compileAndRun() {
       elif [[ $instrset -eq 10 ]] ; then
         isetoption="/QxCORE-AVX512"
       fi      
-      parameters="/D testcase=$testcase /D vtype=$vtype /D rtype=$rtype /D INSTRSET=$instrset /D funcname=$funcname"
+      parameters="/D testcase=$testcase /D vtype=$vtype /D rtype=$rtype /D INSTRSET=$instrset /D funcname=$funcname $pardefms"
       echo "icl $parameters $options -I$include $isetoption $parix $extraoptions $testbench $extrasource"
       eval icl.exe $parameters $options -I$include $isetoption $parix $extraoptions $testbench $extrasource
       
@@ -243,7 +264,7 @@ compileAndRun() {
   if [[ $instrset -gt $maxiset ]] ; then
     if [ -e "$emulator" ] ; then
       # emulate and run compiled program
-      $emulator -future -- ./$exefilename
+      eval $emulator -future -- ./$exefilename $programargs
     else
       echo "*** emulator $emulator not found\n"
       echo "*** emulator $emulator not found\n" >> $outfile
@@ -251,7 +272,7 @@ compileAndRun() {
     fi
   else
     # run compiled program
-    ./$exefilename  
+    eval ./$exefilename $programargs
   fi
   
   returncode=$?
@@ -268,17 +289,17 @@ setCompiler() {
   compiler=$1  # set compiler variable
   if [ $compiler -eq 1 ] ; then
     # Gnu compiler
-    options="-m$mode -std=c++17 -O3 -fno-trapping-math -o$exefilename"
+    options="-m$mode -std=c++17 -O3 -fno-trapping-math -pthread -o$exefilename"
     # -ffinite-math-only will spoil checks for nan and infinite
   elif [ $compiler -eq 2 ] ; then
     # Clang compiler
-    options="-m$mode -std=c++17 -O3 -fno-trapping-math -o$exefilename"
+    options="-m$mode -std=c++17 -O3 -fno-trapping-math -pthread -o$exefilename"
   elif [ $compiler -eq 3 ] ; then
     # Intel compiler for Linux, legacy ("classic")
-    options="-m$mode -std=c++17 -O3 -fno-trapping-math -fp-model precise -o$exefilename"    
+    options="-m$mode -std=c++17 -O3 -fno-trapping-math -fp-model precise -pthread -o$exefilename"    
   elif [ $compiler -eq 4 ] ; then
     # Intel compiler for Linux, clang based
-    options="-m$mode -std=c++17 -O3 -fno-trapping-math -fp-model precise -o$exefilename"
+    options="-m$mode -std=c++17 -O3 -fno-trapping-math -fp-model precise -pthread -o$exefilename"
   elif [ $compiler -eq 10 ] ; then
     # MS compiler for Windows VS2019
     os=1
@@ -373,6 +394,8 @@ testbench=testbench1.cpp
 include=../src2
 outfile=/dev/null
 seed=0
+programargs=""
+defines=""
 compiler=0
 maxiset=
 setCompiler 1
@@ -409,7 +432,7 @@ do
     IFS="="
     spliteq=(${line1:1})
     varname="${spliteq[0]}"
-    value="${spliteq[1]}"
+    value="${line1#*=}"          # everything after the first '='
     varname=${varname// }
     value=${value// }
     #echo -e "varname:$varname value:$value \n"
@@ -446,6 +469,12 @@ do
     elif [[ $varname == "seed" ]] ; then
       # set compiler
       seed=$value
+    elif [[ $varname == "arguments" ]] ; then
+      # set command line arguments for test program. '+' is converted to space
+      programargs=${value//\+/ }
+    elif [[ $varname == "define" ]] ; then
+      # set extra macros to define for the testbench, separated by '+'
+      defines=$value
     else
       echo "Error: Unknown parameter $varname" >> $outfile
     fi    
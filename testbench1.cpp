@@ -1,7 +1,7 @@
 /****************************  testbench1.cpp   *******************************
 * Author:        Agner Fog
 * Date created:  2019-04-09
-* Last modified: 2023-12-02
+* Last modified: 2026-10-19
 * Version:       2.02.02
 * Project:       Testbench for vector class library
 * Description:
@@ -47,6 +47,11 @@ Test cases:
 5:   operator /            (integer types. divide by scalar)
 6:   operator /            (signed integer types. divide by compile-time constant)
 7:   operator /            (unsigned integer types. divide by compile-time constant)
+30:  operator /            (integer types. all divisors in a compile-time list. const_int or
+                           const_uint compared with runtime divisor and scalar /, with clock cycles)
+31:  operator /            (8 and 16 bit integer types. all runtime divisors with all dividends.
+                           Distributed between threads: testbench1 [nthreads]. Clock cycles
+                           for divisor setup and for division are reported separately)
 8:   unary -
 9:   max
 10:  min
@@ -163,6 +168,26 @@ Test cases:
 
 #include <vectorclass.h>     // vector class library
 
+#if testcase == 30 || testcase == 31
+#include <utility>
+#include <type_traits>
+#ifdef _MSC_VER
+#include <intrin.h>          // __rdtsc
+#else
+#include <x86intrin.h>       // __rdtsc
+#endif
+#endif
+#if testcase == 31
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+#endif
+
 #ifdef VCL_NAMESPACE
 using namespace VCL_NAMESPACE;
 #endif
@@ -284,6 +309,37 @@ inline rtype testFunction(vtype const& a, vtype const& b) {
 RT referenceFunction(ST a, ST b) { 
     return a / divisor; }
 
+#elif testcase == 30   // /  int types: divide by each constant in a list of compile-time divisors
+// The test function and benchmark are in divisorSweep() below.
+// All dividends are tested for 8-bit and 16-bit types
+#define SEPARATE_TEST  divisorSweep    // replaces the generic test loop in main
+static_assert(sizeof(ST) <= 4, "8, 16, and 32 bit integer types only");
+const bool divSigned = ST(-1) < ST(0);
+const int64_t divMax  = int64_t((uint64_t(1) << (sizeof(ST)*8 - divSigned)) - 1);  // highest value in type
+const int64_t divMin  = divSigned ? -divMax - 1 : 0;
+const int64_t divHigh = (divMax >> 1) + 1;       // highest power of 2 in type
+const int divDataSize = 0x10000;                 // number of dividends
+// divisor class for runtime divisor. 8-bit types use 16-bit divisors
+typedef std::conditional_t<sizeof(ST) == 4, 
+    std::conditional_t<divSigned, Divisor_i, Divisor_ui>,
+    std::conditional_t<divSigned, Divisor_s, Divisor_us>> DivisorType;
+// list of divisors: 1, powers of 2, type extremes, small primes, large odd values
+typedef std::conditional_t<divSigned,
+    std::integer_sequence<int64_t, 1, -1, 2, -2, 4, 8, 16, -16, divHigh, -divHigh, divMin, 
+        3, -3, 5, 7, -7, 10, 11, 13, 27, 100, -100, divHigh-1, divHigh+1, divMax-2, divMax, -divMax>,
+    std::integer_sequence<int64_t, 1, 2, 4, 8, 16, divHigh, 
+        3, 5, 7, 10, 11, 13, 27, 100, divHigh-1, divHigh+1, divHigh+divHigh/2, divMax-2, divMax-1, divMax>
+    > DivisorList;
+
+#elif testcase == 31   // /  8-bit and 16-bit int types: all runtime divisors with all dividends
+// The test function and benchmark are in divideAll() below
+#define SEPARATE_TEST  divideAll       // replaces the generic test loop in main
+static_assert(sizeof(ST) <= 2, "8 and 16 bit integer types only");
+const bool divSigned = ST(-1) < ST(0);
+const int divNumValues = 1 << (sizeof(ST) * 8);  // number of possible values of ST
+// divisor class for runtime divisor. 8-bit types use 16-bit divisors
+typedef std::conditional_t<divSigned, Divisor_s, Divisor_us> DivisorType;
+
 #elif testcase == 8    // unary - 
 inline rtype testFunction(vtype const& a, vtype const& b) { return -b; }
 RT referenceFunction(ST a, ST b) { return -b; }
@@ -1868,8 +1924,236 @@ inline bool compare_vectors(T const& a, T const& b) {
 }
 
 
+#if testcase == 30 || testcase == 31
+// read time stamp counter
+static inline uint64_t readTSC() {
+    return __rdtsc();
+}
+#endif
+
+#if testcase == 30
+// ----------------------------------------------------------------------------
+//     Test case 30: division by each divisor in a list of compile-time constants
+// ----------------------------------------------------------------------------
+
+// Divide by compile-time constant d
+template <int64_t d>
+inline vtype divideConst(vtype const& a) {
+    if constexpr (divSigned) return a / const_int(d);
+    else return a / const_uint(d);
+}
+
+volatile int64_t divRuntime;       // divisor hidden from the compiler
+volatile uint64_t divSink;         // prevent optimizing away the results
+
+// Test divisor d with const_int or const_uint, runtime divisor, and scalar division.
+// Verify the vector results and print clock cycles per element
+template <int64_t d>
+void testDivisor(ST const * data, int n) {
+    const int repeats = 50;                      // repetitions of timing loops
+    static ST result[divDataSize];               // results of vector division
+    static ST scalarResult[divDataSize];         // results of scalar division
+    uint64_t best[3] = {~uint64_t(0), ~uint64_t(0), ~uint64_t(0)};
+    divRuntime = d;
+    DivisorType dv = DivisorType(ST(divRuntime)); // runtime divisor
+    int64_t dr = divRuntime;                     // runtime scalar divisor
+    const int vectorsize = vtype::size();
+    vtype a;
+    int i, r, errors = 0;
+    // verify
+    for (int method = 0; method < 2; method++) {
+        for (i = 0; i < n; i += vectorsize) {
+            a.load(data + i);
+            if (method == 0) divideConst<d>(a).store(result + i);
+            else (a / dv).store(result + i);
+        }
+        for (i = 0; i < n; i++) {
+            ST expected = ST(int64_t(data[i]) / d);
+            if (result[i] != expected) {
+                if (++numerr <= maxerrors) {
+                    printf("\nError: "); printVal(data[i]); printf(" / %lli %s -> ", (long long)d, method ? "runtime" : "const");
+                    printVal(result[i]);  printf(" != ");  printVal(expected);
+                }
+                errors++;
+                break;
+            }
+        }
+    }
+    for (r = 0; r < repeats; r++) {
+        // compile-time constant
+        uint64_t time0 = readTSC();
+        for (i = 0; i < n; i += vectorsize) {
+            divideConst<d>(a.load(data + i)).store(result + i);
+        }
+        uint64_t time1 = readTSC();
+        if (time1 - time0 < best[0]) best[0] = time1 - time0;
+        // runtime divisor
+        time0 = readTSC();
+        for (i = 0; i < n; i += vectorsize) {
+            (a.load(data + i) / dv).store(result + i);
+        }
+        time1 = readTSC();
+        if (time1 - time0 < best[1]) best[1] = time1 - time0;
+        // scalar division
+        time0 = readTSC();
+        for (i = 0; i < n; i++) {
+            if constexpr (divSigned && sizeof(ST) == 4 && d == -1) {
+                scalarResult[i] = ST(int64_t(data[i]) / dr);   // avoid overflow trap
+            }
+            else {
+                scalarResult[i] = ST(data[i] / ST(dr));
+            }
+        }
+        time1 = readTSC();
+        if (time1 - time0 < best[2]) best[2] = time1 - time0;
+    }
+    divSink = uint64_t(result[n-1]) + uint64_t(scalarResult[n-1]);
+    printf("\n%12lli %10.3f %10.3f %10.3f", (long long)d,
+        double(best[0]) / n, double(best[1]) / n, double(best[2]) / n);
+    if (errors) printf("  error");
+}
+
+// Test all divisors in list
+template <int64_t... d>
+void testAllDivisors(ST const * data, int n, std::integer_sequence<int64_t, d...>) {
+    (testDivisor<d>(data, n), ...);
+}
+
+// Test all divisors with all dividends for 8 and 16 bit types, or random dividends
+// and boundary values for 32 bit types
+void divisorSweep(int argc, char* argv[]) {
+    static ST data[divDataSize];
+    int n;
+    if constexpr (sizeof(ST) <= 2) {
+        n = 1 << (sizeof(ST) * 8);               // all dividends
+        for (int i = 0; i < n; i++) data[i] = ST(i);
+    }
+    else {
+        TestData<ST> testdata;
+        n = divDataSize;
+        for (int i = 0; i < n; i++) data[i] = testdata.list[i % testdata.size()];
+        for (int i = testdata.size(); i < n; i++) data[i] = get_random<ST>(ran);
+    }
+    printf("\nDivision by compile-time constant (%s), runtime divisor, and scalar division, %i dividends", 
+        divSigned ? "const_int" : "const_uint", n);
+    printf("\nClock cycles per element:");
+    printf("\n%12s %10s %10s %10s", "divisor", "constant", "runtime", "scalar");
+    testAllDivisors(data, n, DivisorList());
+}
+#endif
+
+#if testcase == 31
+// ----------------------------------------------------------------------------
+//     Test case 31: division by all divisors with all dividends
+// ----------------------------------------------------------------------------
+
+ST allDividends[divNumValues];                   // all values of type ST
+std::atomic<int> nextDivisor(0);                 // next divisor to test by any thread
+std::atomic<int> divErrors(0);                   // number of wrong results
+std::mutex printMutex;                           // prevent threads from printing simultaneously
+
+// Divide all dividends by each divisor taken from nextDivisor and compare with scalar division.
+// Runs in multiple threads
+void divideAllThread() {
+    const int vectorsize = vtype::size();
+    static thread_local ST result[divNumValues];
+    int i, k;
+    while ((k = nextDivisor++) < divNumValues) {
+        ST d = ST(k);
+        if (d == 0) continue;
+        DivisorType dv = DivisorType(d);         // set up runtime divisor
+        for (i = 0; i < divNumValues; i += vectorsize) {
+            (vtype().load(allDividends + i) / dv).store(result + i);
+        }
+        for (i = 0; i < divNumValues; i++) {
+            ST expected = ST(int32_t(allDividends[i]) / int32_t(d));
+            if (result[i] != expected && divErrors++ < maxerrors) {
+                std::lock_guard<std::mutex> lock(printMutex);
+                printf("\nError: ");  printVal(allDividends[i]);  printf(" / ");  printVal(d);
+                printf(" -> ");  printVal(result[i]);  printf(" != ");  printVal(expected);
+            }
+        }
+    }
+}
+
+volatile int divVolatile = 1;     // value hidden from the compiler
+volatile uint64_t divSink;        // prevent optimizing away the results
+
+// Measure clock cycles for setting up a divisor and for dividing a vector
+void divisionBenchmark() {
+    const int vectorsize = vtype::size();
+    const int nbench = 4096;                     // number of dividends in benchmark
+    const int repeats = 20;                      // repetitions of timing loops
+    static ST benchData[nbench], benchResult[nbench];
+    static unsigned char setupStore[256][sizeof(DivisorType)]; // store divisors to prevent optimizing away
+    uint64_t best[3] = {~uint64_t(0), ~uint64_t(0), ~uint64_t(0)};
+    ST d0 = ST(divVolatile);
+    int i, k, r;
+    for (i = 0; i < nbench; i++) benchData[i] = ST(i * 7);
+    for (r = 0; r < repeats; r++) {
+        // set up all divisors
+        uint64_t time0 = readTSC();
+        for (k = 1; k < divNumValues; k++) {
+            DivisorType dv = DivisorType(ST(k * d0));
+            memcpy(setupStore[k & 0xFF], &dv, sizeof(dv));
+        }
+        uint64_t time1 = readTSC();
+        if (time1 - time0 < best[0]) best[0] = time1 - time0;
+        // divide by the same divisor
+        DivisorType dv = DivisorType(ST(d0 * 7));
+        time0 = readTSC();
+        for (i = 0; i < nbench; i += vectorsize) {
+            (vtype().load(benchData + i) / dv).store(benchResult + i);
+        }
+        time1 = readTSC();
+        if (time1 - time0 < best[1]) best[1] = time1 - time0;
+        // set up a new odd divisor for each vector
+        time0 = readTSC();
+        for (i = 0; i < nbench; i += vectorsize) {
+            (vtype().load(benchData + i) / DivisorType(ST(i * 2 + d0))).store(benchResult + i);
+        }
+        time1 = readTSC();
+        if (time1 - time0 < best[2]) best[2] = time1 - time0;
+    }
+    divSink = uint64_t(benchResult[nbench-1]) + setupStore[1][0];
+    printf("\nClock cycles: divisor setup %.2f, divide %.2f per vector, setup and divide %.2f per vector",
+        double(best[0]) / (divNumValues - 1), double(best[1]) * vectorsize / nbench, double(best[2]) * vectorsize / nbench);
+}
+
+// Divide all dividends by all divisors, using nthreads threads, then measure clock cycles
+void divideAll(int argc, char* argv[]) {
+    int nthreads = 0;                            // default = all hardware threads
+    if (argc > 1) nthreads = atoi(argv[1]);
+    if (nthreads <= 0) nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0) nthreads = 1;
+    for (int i = 0; i < divNumValues; i++) allDividends[i] = ST(i);
+    auto time0 = std::chrono::steady_clock::now();
+    std::thread * threads = new std::thread[nthreads];
+    int t;
+    for (t = 0; t < nthreads; t++) threads[t] = std::thread(divideAllThread);
+    for (t = 0; t < nthreads; t++) threads[t].join();
+    delete[] threads;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time0).count();
+    printf("\nDivision of %s by %i runtime divisors with %i dividends",
+        TOSTRING(vtype), divNumValues - 1, divNumValues);
+    printf("\n%.1f seconds, %i threads, %i errors", seconds, nthreads, int(divErrors));
+    numerr = divErrors;
+    divisionBenchmark();
+}
+#endif
+
+
 // program entry
-int main() {
+int main(int argc, char* argv[]) {
+#ifdef SEPARATE_TEST
+    // test case has its own test function
+    SEPARATE_TEST(argc, argv);
+    if (numerr == 0) {
+        printf("\nsuccess\n");
+    }
+    printf("\n");
+    return numerr;
+#else
     vtype a(ST(0)), b(ST(0));             // operand vectors
     rtype result;                 // result vector
     rtype expected;               // expected result
@@ -1971,4 +2255,5 @@ int main() {
     printf("\n");
 
     return numerr;
+#endif  // SEPARATE_TEST
 }
@@ -1,7 +1,7 @@
 /****************************  testbench2.cpp   *******************************
 * Author:        Agner Fog
 * Date created:  2019-04-15
-* Last modified: 2023-07-04
+* Last modified: 2026-10-19
 * Version:       2.02.02
 * Project:       Testbench for vector class library, 2: permute functions etc.
 * Description:
@@ -27,6 +27,17 @@
 *
 * seed:      Seed for random number generator. May be any integer
 *
+* NUMSAMPLES: Optional. Maximum number of sign patterns in test case 18. Default 256
+*
+* PATTERNFILE: Name of include file with a batch of index patterns for test case 14 and 15.
+*            This file is generated by fuzzpermute.sh
+*
+* LISTSIZE:  Optional. Size of random test data lists. Default 0x200
+*
+* TABLESIZE: Optional. Size of index and data tables for lookup, gather and scatter.
+*            Default 1024. Must be compile-time constant because it is used as 
+*            template parameter in lookup<tablesize>
+*
 * INSTRSET:  Desired instruction set. Needs to be specified for MS compiler,
 *            but determined automatically for other compilers. Values:
 *            2:  SSE2
@@ -41,6 +52,12 @@
 *
 * testcase: A number defining the type of function to test
 *
+* Command line parameters for the compiled program (optional):
+*            testbench2 [ntest [nthreads]]
+*            ntest:    Number of randomized test runs for lookup and gather (test case 3-6, 10)
+*                      per thread. Default 20 for lookup, 10 for gather
+*            nthreads: Number of threads. Each thread uses an independent random number
+*                      stream. Default 1. 0 means use all hardware threads
 *
 * Compile with any compiler supported by VCL.
 * Specify the desired instruction set and optimization options as parameters
@@ -62,10 +79,27 @@ Test cases:
 10: gather
 11: scatter with fixed indexes
 12: scatter with variable indexes
+13: scatter with variable indexes, conflict stress: controlled rates of duplicate
+    indexes. Checks that the highest element wins and measures clock cycles
+14: permute, batch of many index patterns from generated include file PATTERNFILE
+15: blend, batch of many index patterns from generated include file PATTERNFILE
+16: shift_bytes_up, all shift counts from 0 to vector size in one program, with clock cycles
+17: shift_bytes_down, all shift counts from 0 to vector size in one program, with clock cycles
+18: change_sign, all sign patterns, or a random sample of NUMSAMPLES patterns if there are
+    more than NUMSAMPLES, in one program, with clock cycles for each pattern
 *****************************************************************************/
 
 #include <stdio.h>
-
+#include <stdlib.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#ifdef _MSC_VER
+#include <intrin.h>                    // __rdtsc
+#else
+#include <x86intrin.h>                 // __rdtsc
+#endif
 
 //#define __AVX512VBMI__
 //#define __AVX512VBMI2__
@@ -107,6 +141,9 @@ Test cases:
 
 #define seed 1
 
+#define LISTSIZE 0x200
+#define TABLESIZE 1024
+
 
 #else
 // ----------------------------------------------------------------------------
@@ -128,6 +165,14 @@ Test cases:
 #define funcname permute2
 #endif
 
+// size of random data lists and tables
+#ifndef LISTSIZE
+#define LISTSIZE 0x200
+#endif
+#ifndef TABLESIZE
+#define TABLESIZE 1024
+#endif
+
 // indexes
 #ifndef indexes
 #define indexes 0,0
@@ -163,14 +208,16 @@ const int vectorsize = sizeof(vtype) / sizeof(ST); // size of vector
 int indexlist[vectorsize] = { indexes };         // make list of indexes
 const int indexnum = sizeof(indexlist) / sizeof(int);  // number of indexes
 
-const int tablesize = 1024;                      // size of index table
-STI indextable[tablesize];                       // index table for lookup, gather, scatter
-RT  datatable[tablesize];                        // data table for lookup<>
+const int tablesize = TABLESIZE;                 // size of index table
+// Tables and error position are thread-local because randomized tests may run in multiple threads
+thread_local STI indextable[tablesize];          // index table for lookup, gather, scatter
+thread_local RT  datatable[tablesize];           // data table for lookup<>
 
 
 const int maxerrors = 10;                        // maximum errors to report
-int numerr = 0;                                  // count errors
-int error = 0;                                   // position of error + 1, -1 = index out of range
+std::atomic<int> numerr(0);                      // count errors, all threads
+thread_local int error = 0;                      // position of error + 1, -1 = index out of range
+std::mutex printMutex;                           // prevent threads from mixing their error reports
 
 
 /************************************************************************
@@ -179,11 +226,13 @@ int error = 0;                                   // position of error + 1, -1 =
 *
 ************************************************************************/
 
-#if   testcase == 1    // permute
+#if   testcase == 1 || testcase == 14   // permute
+#if   testcase == 1
 inline vtype testFunction(vtype const& a, vtype const&) {
     vtype r = funcname<indexes>(a);                // call permute function
     return r;
 }
+#endif
 
 vtype compareFunction(vtype const& r, vtype const& a, vtype const&) {
     // compare result r with expected value of permute<indexes>(a)
@@ -213,11 +262,13 @@ vtype compareFunction(vtype const& r, vtype const& a, vtype const&) {
 }
 
 
-#elif   testcase == 2    // blend
+#elif   testcase == 2 || testcase == 15   // blend
+#if   testcase == 2
 inline vtype testFunction(vtype const& a, vtype const& b) {
     vtype r = funcname<indexes>(a, b);          // call blend function
     return r;
 }
+#endif
 
 vtype compareFunction(vtype const& r, vtype const& a, vtype const& b) {
     // compare result r with expected value of permute<indexes>(a)
@@ -493,7 +544,7 @@ void compareFunction(rtype const & a, RT * table) {
     }
 }
 
-#elif   testcase == 12    // scatter function with variable indexes
+#elif   testcase == 12 || testcase == 13   // scatter function with variable indexes
 
 inline void testFunction(vtypei const & ix, int limit, rtype const & a, RT * table) {
     funcname(ix, limit, a, table);         // call lookup function
@@ -501,7 +552,9 @@ inline void testFunction(vtypei const & ix, int limit, rtype const & a, RT * tab
 }
 
 void compareFunction(vtypei const & ix, int limit, rtype const & a, RT * table) {
-    // compare result r with expected value
+    // compare result r with expected value.
+    // If two elements have the same index then the element with the highest 
+    // position is stored. This is modeled by looping upwards
     error = 0;                                      // no error yet
     for (int j = 0; j < vectorsize; j++) {          // loop through result vector
         int i = (int)ix[j];                         // corresponding index
@@ -517,6 +570,75 @@ void compareFunction(vtypei const & ix, int limit, rtype const & a, RT * table)
     }
 }
 
+#elif   testcase == 16 || testcase == 17   // shift_bytes_up / shift_bytes_down, all shift counts
+
+template <int n>
+inline vtype testFunction(vtype const& a) {
+#if testcase == 16
+    return shift_bytes_up<n>(a);                 // call shift_bytes_up function
+#else
+    return shift_bytes_down<n>(a);               // call shift_bytes_down function
+#endif
+}
+
+vtype compareFunction(int count, vtype const& r, vtype const& a) {
+    // compare result r with a shifted by count elements, with zeroes shifted in
+    ST result[vectorsize];
+    error = 0;                                      // no error yet
+    for (int j = 0; j < vectorsize; j++) {          // loop through result vector
+        int i = testcase == 16 ? j - count : j + count; // source position
+        result[j] = (i >= 0 && i < vectorsize) ? a[i] : ST(0);
+        if (r[j] != result[j]) {                    // error
+            error = j + 1;                          // error position
+        }
+    }
+    return vtype().load(result);                    // return expected vector
+}
+
+#elif   testcase == 18   // change_sign, many sign patterns
+
+#ifndef NUMSAMPLES
+#define NUMSAMPLES 256
+#endif
+
+// call change_sign with the sign pattern given by the bits of mask
+template <uint32_t mask, int... j>
+inline vtype testFunction(vtype const& a, std::integer_sequence<int, j...>) {
+    return change_sign<int((mask >> j) & 1)...>(a);
+}
+
+vtype compareFunction(uint32_t mask, vtype const& r, vtype const& a) {
+    ST result[vectorsize];
+    a.store(result);
+    error = 0;                                    // no error yet
+    for (int j = 0; j < vectorsize; j++) {        // loop through result vector
+        if ((mask >> j) & 1) {
+            result[j] = -result[j];               // change sign
+        }
+        if (r[j] != result[j]) {                  // error
+            error = j + 1;                        // error position
+        }
+    }
+    return vtype().load(result);                  // return expected vector
+}
+
+// number of sign patterns to test
+const int numpatterns = (vectorsize < 31 && (1 << vectorsize) <= NUMSAMPLES) ? 1 << vectorsize : NUMSAMPLES;
+
+// get sign pattern number k. All patterns are enumerated if there are no more than NUMSAMPLES.
+// Otherwise, pattern 0 is all zero, pattern 1 is all one, and the rest are pseudorandom
+constexpr uint32_t patternMask(int k) {
+    const uint32_t fullmask = vectorsize >= 32 ? 0xFFFFFFFFu : (1u << vectorsize) - 1;
+    if (vectorsize < 31 && numpatterns == (1 << vectorsize)) return uint32_t(k);
+    if (k == 0) return 0;
+    if (k == 1) return fullmask;
+    uint64_t x = uint64_t(seed) * 0x9E3779B97F4A7C15u + uint64_t(k); // hash function
+    x ^= x >> 30;  x *= 0xBF58476D1CE4E5B9u;
+    x ^= x >> 27;  x *= 0x94D049BB133111EBu;
+    x ^= x >> 31;
+    return uint32_t(x) & fullmask;
+}
+
 #else
 // End of test cases
 #error unknown test case
@@ -524,6 +646,44 @@ void compareFunction(vtypei const & ix, int limit, rtype const & a, RT * table)
 #endif
 
 
+#if   testcase == 14 || testcase == 15    // batch of permute or blend patterns
+// The include file PATTERNFILE contains lines of the form PATTERN(i0, i1, ...)
+// with one index list for each function instance to test.
+// The compare function of test case 1 or 2 is used with indexlist set to each pattern
+#ifndef PATTERNFILE
+#define PATTERNFILE "fuzzpatterns.h"
+#endif
+
+template <int... i>
+inline vtype testFunction(vtype const& a, vtype const& b) {
+#if testcase == 14
+    return funcname<i...>(a);                    // call permute function
+#else
+    return funcname<i...>(a, b);                 // call blend function
+#endif
+}
+
+// list of index patterns
+#define PATTERN(...) { __VA_ARGS__ },
+const int patternlist[][vectorsize] = {
+#include PATTERNFILE
+};
+#undef PATTERN
+
+// list of function instances, one for each pattern
+#define PATTERN(...) testFunction<__VA_ARGS__>,
+vtype (* const functionlist[])(vtype const&, vtype const&) = {
+#include PATTERNFILE
+};
+#undef PATTERN
+
+const int numpatterns = sizeof(patternlist) / sizeof(patternlist[0]);
+#endif
+
+// test case that defines the meaning of indexlist in error reports
+const int basecase = testcase == 14 ? 1 : testcase == 15 ? 2 : testcase == 16 ? 7 : testcase == 17 ? 8 : testcase == 18 ? 9 : testcase;
+
+
 
 // ----------------------------------------------------------------------------
 //                           Overhead functions
@@ -650,8 +810,8 @@ bool get_random<bool>(ranGen & rangen) {
 }
 
 
-// make random number generator instance
-ranGen ran(seed);
+// make random number generator instance. Each thread has its own
+thread_local ranGen ran(seed);
 
 // template to generate list of testdata
 template <typename T>
@@ -659,7 +819,7 @@ class TestData {
 public:
     enum LS {
         // define array size. Must be a multiple of vector size:
-        listsize = 0x200
+        listsize = LISTSIZE
     };
     TestData(){};                                // constructor
     void makeRandom() {                          // fill random data into array
@@ -673,11 +833,13 @@ public:
     }
 };
 
-// make random indexes
-vtypei makeIndexes(int n) {
+// make random indexes.
+// The first 'fill' entries of indextable and datatable are filled with new random values.
+// A small fill value makes many test runs faster
+vtypei makeIndexes(int n, int fill = tablesize) {
     int i;                                       // loop counter
     // fill index table
-    for (i = 0; i < tablesize; i++) {
+    for (i = 0; i < fill; i++) {
         uint32_t ix = get_random<uint32_t>(ran); // random index
         indextable[i] = STI(ix % uint32_t(n));    // modulo n
         datatable[i] = get_random<RT>(ran);
@@ -690,8 +852,43 @@ vtypei makeIndexes(int n) {
     return vi;
 }
 
+// make index vector with a controlled rate of conflicts.
+// Each element duplicates the index of a random earlier element with probability rate,
+// otherwise it gets an index in [0, limit) that is different from all earlier indexes.
+// Returns the number of elements that duplicate an earlier index
+int makeConflictIndexes(vtypei & vi, int limit, double rate) {
+    STI list[vectorsize];
+    int conflicts = 0;
+    uint32_t threshold = uint32_t(rate * 4294967295.);
+    for (int j = 0; j < vectorsize; j++) {
+        uint32_t r = ran.next();
+        if (j > 0 && (r < threshold || rate >= 1.)) {
+            list[j] = list[ran.next() % uint32_t(j)]; // duplicate of earlier index
+            conflicts++;
+        }
+        else {
+            bool unique;
+            do {                                 // find index not used before
+                list[j] = STI(ran.next() % uint32_t(limit));
+                unique = true;
+                for (int k = 0; k < j; k++) {
+                    if (list[k] == list[j]) unique = false;
+                }
+            } while (!unique);
+        }
+    }
+    vi.load(list);
+    return conflicts;
+}
+
+// read time stamp counter for timing
+static inline uint64_t readTSC() {
+    return __rdtsc();
+}
+
 // report if error
 void errorreport(vtype const& a, vtype const& b, rtype const& r, rtype const& e) {
+    std::lock_guard<std::mutex> lock(printMutex);
     if (numerr == 0) {
         printf("\ntest case %i:", testcase);
     }
@@ -701,7 +898,7 @@ void errorreport(vtype const& a, vtype const& b, rtype const& r, rtype const& e)
     printf("\nindex, input, output, expected:");
     for (int j = 0; j < vectorsize; j++) {
         int i = indexlist[j];
-        if constexpr (testcase >= 3) i = (int)indextable[j];
+        if constexpr (basecase >= 3) i = (int)indextable[j];
         if (error - 1 == j || (r[j] != e[j] && i != V_DC)) {
             printf("\n-> ");
         }
@@ -711,7 +908,7 @@ void errorreport(vtype const& a, vtype const& b, rtype const& r, rtype const& e)
         if (i == V_DC) printf("V_DC, ");
         else printf("%4i, ", i);
         printReduced(a[j]);  printf(",  ");
-        if constexpr (testcase == 2) {
+        if constexpr (basecase == 2) {
             printReduced(b[j]);  printf(",  ");
         }
         printReduced(r[j]);  printf(",  ");
@@ -719,43 +916,22 @@ void errorreport(vtype const& a, vtype const& b, rtype const& r, rtype const& e)
     }
 }
 
-
-// program entry
-int main(int argc, char* argv[]) {
-    vtype a, b, c, d;             // operand vectors
-    rtype ss;                     // data to scatter
-    rtype result;                 // result vector
-    rtype expected;               // expected result
-    //const int vectorsize = sizeof(vtype) / sizeof(decltype(a[0]));
-    int ntest = 1;                // number of test runs
-
-    // lists of test data
-    TestData<ST> adata, bdata, cdata, ddata;
-
-#if testcase < 3   // permute and blend
-    // call function to test
-    adata.makeRandom();
-    a.load(adata.list);
-    bdata.makeRandom();
-    b.load(bdata.list);
-
-    vtype r = testFunction(a, b);
-
-    // compare with expected values
-    vtype e = compareFunction(r, a, b);
-
-    if (error) {
-        errorreport(a, b, r, e);
-        numerr++;
+#if (testcase >= 3 && testcase <= 6) || testcase == 10
+// Do ntest randomized tests of lookup or gather functions.
+// This function may run in multiple threads. Each thread has its own random
+// number generator, tables, and test data
+void testRuns(int thread, int ntest) {
+    vtype a(0), b(0), c, d;       // operand vectors
+    rtype ss;                     // data vector
+    if (thread > 0) {
+        ran = ranGen(seed + thread * 1000003);   // independent random number stream for each thread
     }
 
-#elif testcase == 3                              // lookup function with one data vector
+#if testcase == 3                                // lookup function with one data vector
 
-    //adata.makeRandom();
-    ntest = 20;                                  // number of test runs
-    for (int t = 0; t < ntest; t++) {            // loop for test runs
-        vtypei indx;                                 // index vector
-        indx = makeIndexes(vectorsize);          // make random index vector
+    for (int t = 0; t < ntest && numerr < maxerrors; t++) { // loop for test runs
+        vtypei indx;                             // index vector
+        indx = makeIndexes(vectorsize, vectorsize); // make random index vector
         ss.load(datatable);
         rtype r = testFunction(indx, ss);        // call function to test
         rtype e = compareFunction(r, indx, ss);  // compare with expected values
@@ -769,9 +945,8 @@ int main(int argc, char* argv[]) {
 
     rtype ss2;
     vtypei indx;                                      // index vector
-    ntest = 20;                                       // number of test runs
-    for (int t = 0; t < ntest; t++) {                 // loop for test runs
-        indx = makeIndexes(vectorsize * 2);           // make random index vector
+    for (int t = 0; t < ntest && numerr < maxerrors; t++) { // loop for test runs
+        indx = makeIndexes(vectorsize * 2, vectorsize * 2); // make random index vector
         ss.load(datatable);
         ss2.load(datatable + ss.size());
         rtype r = testFunction(indx, ss, ss2);        // call function to test
@@ -784,7 +959,8 @@ int main(int argc, char* argv[]) {
 
 #elif testcase == 5                              // lookup function with four data vectors
 
-    // more test data
+    // test data
+    TestData<ST> adata, bdata, cdata, ddata;
     adata.makeRandom();
     a.load(adata.list);
     bdata.makeRandom();
@@ -795,9 +971,8 @@ int main(int argc, char* argv[]) {
     d.load(ddata.list);
 
     vtypei indx;                                 // index vector
-    ntest = 20;                                  // number of test runs
-    for (int t = 0; t < ntest; t++) {            // loop for test runs
-        indx = makeIndexes(vectorsize * 4);      // make random index vector
+    for (int t = 0; t < ntest && numerr < maxerrors; t++) { // loop for test runs
+        indx = makeIndexes(vectorsize * 4, vectorsize); // make random index vector
         vtype r = testFunction(indx, a, b, c, d);// call function to test
         vtype e = compareFunction(r, indx, a, b, c, d); // compare with expected values
         if (error) {
@@ -809,10 +984,9 @@ int main(int argc, char* argv[]) {
 #elif   testcase == 6    // lookup function with table
 
     vtypei indx;                                 // index vector
-    ntest = 20;                                  // number of test runs
     // test with large table (tablesize)
-    for (int t = 0; t < ntest; t++) {            // loop for test runs
-        indx = makeIndexes(tablesize);           // make random index vector
+    for (int t = 0; t < ntest && numerr < maxerrors; t++) { // loop for test runs
+        indx = makeIndexes(tablesize, t == 0 ? tablesize : vectorsize); // make random index vector
         rtype r = testFunction1(indx, datatable);// call function to test
         rtype e = compareFunction(tablesize, r, indx); // compare with expected values
         if (error) {
@@ -821,8 +995,8 @@ int main(int argc, char* argv[]) {
         }
     }
     // test with small table (vectorsize)
-    for (int t = 0; t < ntest; t++) {            // loop for test runs
-        indx = makeIndexes(vectorsize);          // make random index vector
+    for (int t = 0; t < ntest && numerr < maxerrors; t++) { // loop for test runs
+        indx = makeIndexes(vectorsize, vectorsize * 2); // make random index vector
         rtype r = testFunction2(indx, datatable);// call function to test
         rtype e = compareFunction(vectorsize, r, indx); // compare with expected values
         if (error) {
@@ -832,8 +1006,8 @@ int main(int argc, char* argv[]) {
     }
 
     // test with small table (vectorsize*2-1)
-    for (int t = 0; t < ntest; t++) {            // loop for test runs
-        indx = makeIndexes(vectorsize * 2 - 1);  // make random index vector
+    for (int t = 0; t < ntest && numerr < maxerrors; t++) { // loop for test runs
+        indx = makeIndexes(vectorsize * 2 - 1, vectorsize * 2); // make random index vector
         rtype r = testFunction3(indx, datatable);// call function to test
         rtype e = compareFunction(vectorsize * 2, r, indx); // compare with expected values
         if (error) {
@@ -842,59 +1016,228 @@ int main(int argc, char* argv[]) {
         }
     }
 
-#elif   testcase == 7 || testcase == 8   // shift_bytes_up / shift_bytes_down
-    // Note: 'indexes' is set to the shift count
+#elif   testcase == 10    // gather function with table
 
-    adata.makeRandom();
-    a.load(adata.list);
+    STI indxlst[vectorsize] = { indexes };      // index vector
+    vtypei indx = vtypei().load(indxlst);
 
-    vtype r = testFunction(a);
+    // test with large table (tablesize)
+    for (int t = 0; t < ntest && numerr < maxerrors; t++) { // loop for test runs
+        makeIndexes(tablesize);                  // random data in table
+        rtype r = testFunction(indx, datatable); // call function to test
+        rtype e = compareFunction(r, indx);      // compare with expected values
+        if (error) {
+            errorreport(a, b, r, e);
+            numerr++;
+        }
+    }
 
-    error = 0;
+#endif
+}
+#endif
 
-    // compare with expected values
-    vtype e = compareFunction(r, a);
 
-    if (error) {
-        errorreport(a, b, r, e);
-        numerr++;
+#if testcase == 16 || testcase == 17
+// Test shift count n with random data, and measure clock cycles
+template <int n>
+void testShiftCount() {
+    const int ntest = 20;                        // number of verification runs
+    const int nbench = 256;                      // number of vectors in timing loop
+    const int repeats = 100;                     // repetitions of timing loop
+    static vtype benchdata[nbench];              // input data for timing
+    static vtype benchresult[nbench];            // output from timing
+    ST list[vectorsize];
+    int j, k, t;
+    for (k = 0; k < nbench; k++) {               // make random data
+        for (j = 0; j < vectorsize; j++) list[j] = get_random<ST>(ran);
+        benchdata[k].load(list);
+    }
+    for (t = 0; t < ntest && t < nbench; t++) {  // verify
+        vtype r = testFunction<n>(benchdata[t]);
+        vtype e = compareFunction(n, r, benchdata[t]);
+        if (error) {
+            if (numerr < maxerrors) {
+                errorreport(benchdata[t], benchdata[t], r, e);
+                printf("\nshift count %i", n);
+            }
+            numerr++;
+            break;
+        }
+    }
+    // measure clock cycles
+    uint64_t time0 = readTSC();
+    for (t = 0; t < repeats; t++) {
+        for (k = 0; k < nbench; k++) {
+            benchresult[k] = testFunction<n>(benchdata[k]);
+        }
     }
+    uint64_t time1 = readTSC();
+    printf("\n%5i  %10.2f", n, double(time1 - time0) / (double(repeats) * nbench));
+}
+
+// Test all shift counts from 0 to vectorsize
+template <int... n>
+void testAllShiftCounts(std::integer_sequence<int, n...>) {
+    (testShiftCount<n>(), ...);
+}
+#endif
+
 
-#elif   testcase == 9  // change_sign
+#if testcase == 18
+const int nbench = 256;                          // number of vectors in timing loop
+const int repeats = 100;                         // repetitions of timing loop
+vtype benchdata[nbench];                         // input data for timing
+vtype benchresult[nbench];                       // output from timing
+
+// Test sign pattern mask with random data, and measure clock cycles
+template <uint32_t mask>
+void testSignPattern() {
+    const int ntest = 20;                        // number of verification runs
+    int j, k, t;
+    for (t = 0; t < ntest; t++) {                // verify
+        vtype r = testFunction<mask>(benchdata[t], std::make_integer_sequence<int, vectorsize>());
+        vtype e = compareFunction(mask, r, benchdata[t]);
+        if (error) {
+            if (numerr < maxerrors) {
+                errorreport(benchdata[t], benchdata[t], r, e);
+                printf("\nsign pattern 0x%X", mask);
+            }
+            numerr++;
+            break;
+        }
+    }
+    // measure clock cycles
+    uint64_t time0 = readTSC();
+    for (t = 0; t < repeats; t++) {
+        for (k = 0; k < nbench; k++) {
+            benchresult[k] = testFunction<mask>(benchdata[k], std::make_integer_sequence<int, vectorsize>());
+        }
+    }
+    uint64_t time1 = readTSC();
+    printf("\n");
+    for (j = 0; j < vectorsize; j++) printf("%i", (mask >> j) & 1);  // element 0 first
+    printf("  %10.2f", double(time1 - time0) / (double(repeats) * nbench));
+}
+
+// Test all sign patterns in the list
+template <int... k>
+void testAllSignPatterns(std::integer_sequence<int, k...>) {
+    (testSignPattern<patternMask(k)>(), ...);
+}
+#endif
 
+
+// program entry
+int main(int argc, char* argv[]) {
+    vtype a, b, c, d;             // operand vectors
+    rtype ss;                     // data to scatter
+    rtype result;                 // result vector
+    rtype expected;               // expected result
+    //const int vectorsize = sizeof(vtype) / sizeof(decltype(a[0]));
+    int ntest = 1;                // number of test runs
+
+    // lists of test data
+    TestData<ST> adata, bdata, cdata, ddata;
+
+#if testcase < 3   // permute and blend
+    // call function to test
     adata.makeRandom();
     a.load(adata.list);
+    bdata.makeRandom();
+    b.load(bdata.list);
 
-    vtype r = testFunction(a);
-
-    error = 0;
+    vtype r = testFunction(a, b);
 
     // compare with expected values
-    vtype e = compareFunction(r, a);
+    vtype e = compareFunction(r, a, b);
 
-    if (horizontal_or(r != e)) {
+    if (error) {
         errorreport(a, b, r, e);
         numerr++;
     }
 
+#elif   testcase == 14 || testcase == 15    // batch of permute or blend patterns
 
-#elif   testcase == 10    // gather function with table
+    const int ndata = 4;                         // number of random data sets for each pattern
+    vtype alist[ndata], blist[ndata];
+    int j, k, t;
+    for (t = 0; t < ndata; t++) {
+        adata.makeRandom();
+        alist[t].load(adata.list);
+        bdata.makeRandom();
+        blist[t].load(bdata.list);
+    }
+    for (k = 0; k < numpatterns; k++) {          // loop through patterns
+        for (j = 0; j < vectorsize; j++) indexlist[j] = patternlist[k][j];
+        for (t = 0; t < ndata; t++) {            // loop through data sets
+            vtype r = functionlist[k](alist[t], blist[t]);   // call function to test
+            vtype e = compareFunction(r, alist[t], blist[t]); // compare with expected values
+            if (error) {
+                if (numerr < maxerrors) errorreport(alist[t], blist[t], r, e);
+                numerr++;
+                // write failing pattern in the format of test2.lst
+                printf("\nfailing pattern: ");
+                for (j = 0; j < vectorsize; j++) {
+                    if (j > 0) printf("+");
+                    if (indexlist[j] == V_DC) printf("V_DC");
+                    else printf("%i", indexlist[j]);
+                }
+                break;
+            }
+        }
+    }
+    printf("\n%i patterns tested", numpatterns);
 
+#elif   testcase == 16 || testcase == 17   // shift_bytes_up / shift_bytes_down, all shift counts
 
-    STI indxlst[vectorsize] = { indexes };      // index vector
-    vtypei indx = vtypei().load(indxlst);
+    printf("\n%s, all shift counts, vector size %i", testcase == 16 ? "shift_bytes_up" : "shift_bytes_down", vectorsize);
+    printf("\ncount  clock/vector");
+    testAllShiftCounts(std::make_integer_sequence<int, vectorsize + 1>());
 
-    ntest = 10;                                  // number of test runs
-    // test with large table (tablesize)
-    for (int t = 0; t < ntest; t++) {            // loop for test runs
-        rtype r = testFunction(indx, datatable); // call function to test
-        rtype e = compareFunction(r, indx);      // compare with expected values
-        if (error) {
-            errorreport(a, b, r, e);
-            numerr++;
+#elif   testcase == 18   // change_sign, many sign patterns
+
+    // make random data
+    ST list[vectorsize];
+    int j, k, t;
+    for (k = 0; k < nbench; k++) {
+        for (j = 0; j < vectorsize; j++) list[j] = get_random<ST>(ran);
+        benchdata[k].load(list);
+    }
+    printf("\nchange_sign, %i sign patterns, vector size %i", numpatterns, vectorsize);
+    // measure clock cycles of copy without change_sign, for comparison
+    uint64_t time0 = readTSC();
+    for (t = 0; t < repeats; t++) {
+        for (k = 0; k < nbench; k++) {
+            benchresult[k] = benchdata[k];
         }
     }
-
+    uint64_t time1 = readTSC();
+    printf("\ncopy only: %10.2f clock/vector", double(time1 - time0) / (double(repeats) * nbench));
+    printf("\npattern  clock/vector");
+    testAllSignPatterns(std::make_integer_sequence<int, numpatterns>());
+
+#elif (testcase >= 3 && testcase <= 6) || testcase == 10  // lookup and gather functions
+
+    // get number of test runs and threads from command line
+    ntest = testcase == 10 ? 10 : 20;            // default number of test runs
+    int nthreads = 1;                            // default number of threads
+    if (argc > 1) ntest = atoi(argv[1]);
+    if (argc > 2) nthreads = atoi(argv[2]);
+    if (nthreads <= 0) nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 1) {
+        testRuns(0, ntest);                      // run in main thread
+    }
+    else {
+        std::thread * threads = new std::thread[nthreads];
+        for (int t = 0; t < nthreads; t++) {
+            threads[t] = std::thread(testRuns, t, ntest);
+        }
+        for (int t = 0; t < nthreads; t++) {
+            threads[t].join();
+        }
+        delete[] threads;
+        printf("\n%i threads x %i test runs", nthreads, ntest);
+    }
 
 #elif   testcase == 11    // scatter function with fixed indexes
 
@@ -942,6 +1285,57 @@ int main(int argc, char* argv[]) {
         printf("\nscatter error at position %i", error);
     } 
 
+#elif   testcase == 13    // scatter with variable indexes, conflict stress
+
+    const double rates[] = {0., 0.125, 0.25, 0.5, 0.75, 1.}; // conflict rates to test
+    const int numrates = sizeof(rates) / sizeof(rates[0]);
+    const int limit = tablesize / 2;             // index limit
+    const int nbench = 256;                      // number of index vectors in timing loop
+    const int repeats = 100;                     // repetitions of timing loop
+    static vtypei benchix[nbench];               // index vectors for timing
+    ntest = 1000;                                // number of verification runs per rate
+    int j, t, k;
+
+    // make data to scatter. All elements different so that the winner of a conflict can be identified
+    for (j = 0; j < vectorsize; j++) ss.insert(j, RT(j + 1));
+
+    printf("\nscatter conflict stress, vector size %i", vectorsize);
+    printf("\nconflict rate  actual  clock/vector  clock/element");
+
+    for (k = 0; k < numrates; k++) {
+        // verify
+        for (t = 0; t < ntest && numerr < maxerrors; t++) {
+            vtypei ix;
+            makeConflictIndexes(ix, limit, rates[k]);
+            for (j = 0; j < tablesize; j++) datatable[j] = 0;
+            testFunction(ix, limit, ss, datatable);
+            int numerr0 = numerr;
+            compareFunction(ix, limit, ss, datatable);
+            if (numerr > numerr0) {
+                printf("\nscatter error at position %i, conflict rate %.3f, indexes:", error, rates[k]);
+                for (j = 0; j < vectorsize; j++) printf(" %i", (int)ix[j]);
+                printf("\nstored %i, expected %i", (int)datatable[error], (int)datatable[error + tablesize / 2]);
+            }
+        }
+        // make index vectors for timing
+        int conflicts = 0;
+        for (t = 0; t < nbench; t++) {
+            conflicts += makeConflictIndexes(benchix[t], limit, rates[k]);
+        }
+        // measure clock cycles
+        testFunction(benchix[0], limit, ss, datatable);  // warm up
+        uint64_t time0 = readTSC();
+        for (j = 0; j < repeats; j++) {
+            for (t = 0; t < nbench; t++) {
+                testFunction(benchix[t], limit, ss, datatable);
+            }
+        }
+        uint64_t time1 = readTSC();
+        double clockPerVector = double(time1 - time0) / (double(repeats) * nbench);
+        printf("\n%8.3f     %7.3f  %10.2f  %12.3f", rates[k], double(conflicts) / (double(nbench) * vectorsize),
+            clockPerVector, clockPerVector / vectorsize);
+    }
+
 #else
 
 #error Unknown test case
@@ -1,7 +1,7 @@
 /****************************  testbench3.cpp   *******************************
 * Author:        Agner Fog
 * Date created:  2019-04-11
-* Last modified: 2023-07-04
+* Last modified: 2026-10-19
 * Version:       2.02.02
 * Project:       Testbench for vector class library, 3: mathematical functions
 * Description:
@@ -32,6 +32,90 @@
 *           9:  AVX512F
 *           10: AVX512BW/DQ/VL
 *
+* EXHAUSTIVE_TEST: Optional. Test all float inputs rather than a list of test data.
+*           Only for one-parameter functions with float input.
+*           Inputs with absolute value bigger than MAXF are skipped, except INF.
+*           The inputs are distributed between threads.
+*           The number of threads can be specified on the command line:
+*           testbench3 [nthreads]. Default = all hardware threads.
+* EXPONENT_MIN, EXPONENT_MAX: Optional with EXHAUSTIVE_TEST or BUCKET_SAMPLES. Limit the test 
+*           to inputs with binary exponent in this interval, both signs. 
+*           -127 means zero and subnormal. 128 means INF and NAN (-1023 and 1024 for double)
+* HEATMAP:  Optional. Report max and mean error for each sign and binary exponent of the 
+*           (first) input parameter. 
+* BUCKET_SAMPLES: Optional. Test this number of random inputs for each sign and binary exponent
+*           rather than the default test data. Inputs bigger than MAXF or MAXD are not tested.
+*           The second parameter of two-parameter functions uses the default test data.
+*           Implies HEATMAP.
+* TOPK:     Optional. Number of worst inputs to report. Default 10
+* ERROR_STATISTICS: Optional. Print a histogram of errors and the worst inputs, and append
+*           them to STATFILE. Implied by STATFILE, EXHAUSTIVE_TEST, HEATMAP, BUCKET_SAMPLES,
+*           GRID_TEST, and DENORMAL_TEST. The histogram is collected in all cases
+* STATFILE: Optional. Name of file for error statistics. Default "errorstat.csv". A histogram 
+*           of errors and the worst inputs are appended to this file as comma-separated lines:
+*           hist,testcase,vtype,INSTRSET,count,maxulp,meanulp,bin counts (see binName)
+*           worst,testcase,vtype,INSTRSET,rank,ulp,input1,input2,result,reference
+*           bucket,testcase,vtype,INSTRSET,sign,exponent,count,maxulp,meanulp (with HEATMAP)
+*           region,testcase,vtype,INSTRSET,region,count,maxulp,meanulp,limit,errors (with GRID_TEST)
+*           denormal,testcase,vtype,INSTRSET,mode,data,count,maxulp,meanulp,changed,clocks
+*           (with DENORMAL_TEST)
+* REFERENCE_CACHE: Optional. Store the reference values in a binary file that is shared between
+*           vector types and instruction sets with the same scalar type, test case, and seed.
+*           The file is generated in parallel threads the first time, and memory-mapped
+*           in subsequent runs. It is validated by a checksum and regenerated if invalid.
+*           Only for one-parameter functions with testcase >= 100. Ignored in other cases.
+* CACHEDIR: Optional. Directory for reference cache files. Default "."
+* BENCHMARK: Optional. Measure the speed of the test function and of a scalar loop with the
+*           corresponding standard library function (SCALARFUNC) over the same test data.
+*           Only for testcase >= 100. Compile with and without USEMATHLIB to compare
+*           VCL functions with the SVML library. The results are printed and appended to
+*           the file BENCHFILE as comma-separated lines together with the accuracy:
+*           testcase,vtype,INSTRSET,fma,library,data,vector clocks/element,
+*           scalar clocks/element,speedup,max ULP,mean ULP,emulated
+*           Use isareport.sh to compare the results for different instruction sets.
+* BENCHFILE: Optional. Name of benchmark file. Default "bench3.csv"
+* BENCHREPEAT: Optional. Number of repetitions of benchmark. The fastest is used. Default 20
+* EMULATED: Defined by runtest.sh when the program runs in the emulator because the instruction
+*           set is not supported by the CPU. The benchmark clock counts are not valid then.
+* GRID_TEST: Optional. Test a two-parameter function on dense grids in a number of regions:
+*           log grid: x and y log-uniform over the whole range, both signs
+*           x near 1: x = 1 +/- 2^-k, big y
+*           overflow: x^y near the overflow limit
+*           underflow: x^y near the underflow limit, including subnormal results
+*           The rows of the grids are distributed between threads.
+*           The number of threads can be specified on the command line:
+*           testbench3 [nthreads]. Default = all hardware threads.
+* TRIG_HARD_CASES: Optional. Number of hard inputs for trigonometric functions (testcase 200 - 214).
+*           The inputs are the floating point numbers nearest to k*pi/2 (or k/2 for the *pi 
+*           functions) for a wide range of k up to the input limit, and the hardest cases found
+*           in a search. The reference is calculated with range reduction in double-double
+*           precision. The errors are relative, also for results near zero.
+*           Combine with BENCHMARK to measure the speed of the slow range reduction path.
+*           Not for asin, acos, atan (205 - 207).
+* HARD_SEARCH: Optional with TRIG_HARD_CASES. Number of random k searched for the hardest cases
+*           when an exhaustive search of all k is too slow. Default 0x400000
+*           Accuracy limit: the reduced argument x - k*pi/2 has an absolute error of about
+*           |x|*2^-160. For double inputs closer than 2^-44 ULP to k*pi/2, the reference
+*           has less than long double precision. A warning is printed in this case.
+*           The default search does not find such inputs. Float inputs are not affected.
+* GRID_SIZE: Optional with GRID_TEST. Number of grid points in each dimension of each region.
+*           Default 4096. GRID_SIZE = 65536 gives 2^32 pairs per region
+* GRID_REGIONS: Optional with GRID_TEST. Bit mask of regions to test. Default 0xF = all
+* DENORMAL_TEST: Optional. Run the test function in the four combinations of the flush-to-zero 
+*           (FTZ) and denormals-are-zero (DAZ) modes. Two data sets are used: the default test
+*           data, and inputs that are subnormal or give subnormal results. The reference values
+*           and the accuracy limits are the same in all modes. For each mode and data set, the
+*           max and mean error, the number of results that differ from the default mode, and
+*           the clock cycles per element are reported. Errors are counted only in default mode.
+*           Cannot be combined with EXHAUSTIVE_TEST, GRID_TEST or BENCHMARK
+* DENORMAL_SAMPLES: Optional with DENORMAL_TEST. Number of inputs in each data set. Default 4096
+* DENORMAL_SEARCH: Optional with DENORMAL_TEST. Number of random inputs searched for subnormal
+*           results. Default 0x1000000
+* LONGDOUBLE_REFERENCE: Optional. Calculate the reference values of exp, log, pow, cbrt, and 
+*           hyperbolic functions with the long double library functions rather than with
+*           double-double arithmetic (DD_REFERENCE). The double-double functions are more precise
+*           and give the same results on all compilers. They are faster for most functions
+*
 * Compile with any compiler supported by VCL.
 * Specify the desired instruction set and optimization options as parameters
 * to the compiler.
@@ -103,7 +187,32 @@ Test cases:
 
 #include <stdio.h>
 #include <float.h>
+#include <string.h>
 #include <cmath>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <queue>
+#if defined(BENCHMARK) || defined(DENORMAL_TEST)
+#ifdef _MSC_VER
+#include <intrin.h>               // __rdtsc
+#else
+#include <x86intrin.h>            // __rdtsc
+#endif
+#endif
+
+#ifdef REFERENCE_CACHE            // memory-mapped files
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#endif
 
 #if (defined(__GNUC__) || defined(__clang__)) && !defined (__CYGWIN__)
 //#include <fpu_control.h>        // setting FP control word needed only in WSL version 1
@@ -185,9 +294,12 @@ vtype dummy;
 rtype dummyr;
 typedef decltype(dummy[0]) ST;    // scalar type input vectors
 typedef decltype(dummyr[0]) RT;   // scalar type for return vector
-ST x0;                            // used with IGNORE_UNDERFLOW
+thread_local ST x0;               // used with IGNORE_UNDERFLOW
 
 long double pow_accurate(double x, double y); // reference function
+long double trig_accurate(double x, int func);  // reference function for hard cases
+float delta_unit(float x);
+double delta_unit(double x);
 uint32_t compare_sign(float a, float b);
 uint32_t compare_sign(double a, double b);
 
@@ -219,6 +331,421 @@ double bit_castd(uint64_t x){// uint32_t -> float
     return u.f;
 }
 
+// ----------------------------------------------------------------------------
+//             Double-double arithmetic for reference functions
+// ----------------------------------------------------------------------------
+// A double-double number is an unevaluated sum hi + lo of two doubles with 
+// |lo| <= ulp(hi)/2, giving approximately 106 bits of precision.
+// The reference functions for exp, log, pow, cbrt, and the hyperbolic functions
+// use this arithmetic when DD_REFERENCE is defined. The results do not depend on
+// the quality or precision of the long double math library of the compiler, and
+// the calculation is faster than long double. The trigonometric reference functions 
+// use long double after double-double range reduction.
+// The functions are scalar because referenceFunction is called for one element at a time.
+// The exhaustive, grid, and cache modes calculate reference values in parallel threads.
+// DD_REFERENCE is on by default. Define LONGDOUBLE_REFERENCE to use the long double
+// library functions instead.
+
+#ifndef LONGDOUBLE_REFERENCE
+#define DD_REFERENCE
+#endif
+
+// exact sum: s + e = a + b
+inline void two_sum(double a, double b, double & s, double & e) {
+    s = a + b;
+    double bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+}
+
+// exact sum: s + e = a + b, if |a| >= |b|
+inline void fast_two_sum(double a, double b, double & s, double & e) {
+    s = a + b;
+    e = b - (s - a);
+}
+
+// exact product: p + e = a * b
+inline void two_prod(double a, double b, double & p, double & e) {
+    p = a * b;
+#if INSTRSET >= 8  // FMA
+    e = std::fma(a, b, -p);
+#else              // split a and b into 26-bit halves (Dekker). Gives the same result
+    const double split = 134217729.;             // 2^27 + 1
+    double ta = split * a, ah = ta - (ta - a), al = a - ah;
+    double tb = split * b, bh = tb - (tb - b), bl = b - bh;
+    e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+#endif
+}
+
+// double-double number
+struct ddouble {
+    double hi, lo;
+    ddouble(double h = 0., double l = 0.) : hi(h), lo(l) {}
+    long double value() const {                  // convert to long double
+        if (!std::isfinite(hi)) return hi;
+        return (long double)hi + (long double)lo;
+    }
+};
+
+inline ddouble operator - (ddouble const a) {
+    return ddouble(-a.hi, -a.lo);
+}
+
+inline ddouble operator + (ddouble const a, double const b) {
+    double s, e;
+    two_sum(a.hi, b, s, e);
+    e += a.lo;
+    fast_two_sum(s, e, s, e);
+    return ddouble(s, e);
+}
+
+inline ddouble operator + (ddouble const a, ddouble const b) {
+    double s, e, t, f;
+    two_sum(a.hi, b.hi, s, e);
+    two_sum(a.lo, b.lo, t, f);
+    e += t;
+    fast_two_sum(s, e, s, e);
+    e += f;
+    fast_two_sum(s, e, s, e);
+    return ddouble(s, e);
+}
+
+inline ddouble operator - (ddouble const a, double const b) {
+    return a + (-b);
+}
+
+inline ddouble operator - (ddouble const a, ddouble const b) {
+    return a + (-b);
+}
+
+inline ddouble operator * (ddouble const a, double const b) {
+    double p, e;
+    two_prod(a.hi, b, p, e);
+    if (!std::isfinite(p)) return p;             // INF or NAN. error term would be NAN
+    e += a.lo * b;
+    fast_two_sum(p, e, p, e);
+    return ddouble(p, e);
+}
+
+inline ddouble operator * (ddouble const a, ddouble const b) {
+    double p, e;
+    two_prod(a.hi, b.hi, p, e);
+    if (!std::isfinite(p)) return p;             // INF or NAN. error term would be NAN
+    e += a.hi * b.lo + a.lo * b.hi;
+    fast_two_sum(p, e, p, e);
+    return ddouble(p, e);
+}
+
+inline ddouble operator / (ddouble const a, ddouble const b) {
+    double q1 = a.hi / b.hi;                     // first approximation
+    ddouble r = a - b * q1;                      // remainder
+    double q2 = r.hi / b.hi;                     // correction
+    r = r - b * q2;
+    double q3 = r.hi / b.hi;                     // second correction
+    ddouble q;
+    fast_two_sum(q1, q2, q.hi, q.lo);
+    return q + q3;
+}
+
+// 2^n for -1022 <= n <= 1023
+inline double pow2n(int n) {
+    return bit_castd(uint64_t(n + 1023) << 52);
+}
+
+// multiply by 2^n. Exact unless the result overflows or underflows
+inline ddouble dd_ldexp(ddouble const a, int n) {
+    if (n < -1022 || n > 1023) return ddouble(std::ldexp(a.hi, n), std::ldexp(a.lo, n));
+    double p = pow2n(n);                         // faster than ldexp
+    return ddouble(a.hi * p, a.lo * p);
+}
+
+// square root. a must be positive
+ddouble dd_sqrt(ddouble const a) {
+    double s = std::sqrt(a.hi);
+    if (a.hi <= 0. || !std::isfinite(s)) return s;
+    double p, e;
+    two_prod(s, s, p, e);
+    ddouble r = a - ddouble(p, e);               // remainder a - s^2
+    ddouble y;
+    fast_two_sum(s, r.hi / (2. * s), y.hi, y.lo);  // one Newton-Raphson step
+    return y;
+}
+
+// constants
+const ddouble dd_ln2   (0.6931471805599453, 2.3190468138462996e-17);   // log(2)
+const ddouble dd_ln10  (2.302585092994046, -2.1707562233822494e-16);   // log(10)
+const ddouble dd_log2e (1.4426950408889634, 2.0355273740931033e-17);   // 1/log(2)
+const ddouble dd_log10e(0.4342944819032518, 1.098319650216765e-17);    // 1/log(10)
+const double  dd_exp_max = 709.79;               // exp overflows above this value
+const double  dd_exp_min = -746.;                // exp underflows below this value
+
+// tables of 2^(j/64) and 2^(j/4096), j = 0..63. Calculated by repeated square roots
+const ddouble * dd_exp2_tables() {
+    static ddouble tables[128];
+    static bool ready = [](){
+        ddouble roots[12];                       // 2^(2^-i), i = 1..12
+        ddouble r = 2.;
+        for (int i = 0; i < 12; i++) roots[i] = r = dd_sqrt(r);
+        for (int j = 0; j < 64; j++) {
+            ddouble t1 = 1., t2 = 1.;
+            for (int i = 0; i < 6; i++) {
+                if (j & (32 >> i)) {
+                    t1 = t1 * roots[i];
+                    t2 = t2 * roots[i + 6];
+                }
+            }
+            tables[j] = t1;  tables[j + 64] = t2;
+        }
+        return true;
+    }();
+    (void)ready;
+    return tables;
+}
+
+// expm1(x) for |x| <= log(2)/8192 by Taylor series
+inline ddouble dd_expm1_poly(ddouble const x) {
+    double xd = x.hi;
+    // terms of degree 3 and higher need only double precision
+    double t = (((1./720. * xd + 1./120.) * xd + 1./24.) * xd + 1./6.) * (xd * xd * xd);
+    return x + (x * x * 0.5 + t);
+}
+
+// exp(x) = m * 2^k. Returns m. x must be in the interval [dd_exp_min, dd_exp_max]
+// The result is m - 1 if em1 is true. This is accurate also when k = 0 and m is close to 1
+ddouble dd_exp_core(ddouble const x, int & k, bool em1 = false) {
+    const ddouble * tables = dd_exp2_tables();
+    double n = std::nearbyint(x.hi * (4096. / 0.6931471805599453)); // x / (log(2)/4096)
+    int ni = (int)n;
+    int j = ni & 4095;
+    k = (ni - j) / 4096;
+    ddouble r = x - dd_ln2 * (n * (1./4096.));   // n/4096 is exact. |r| <= log(2)/8192
+    ddouble p = dd_expm1_poly(r);
+    if (j == 0) return em1 ? p : p + 1.;
+    ddouble t = tables[j >> 6] * tables[64 + (j & 63)];  // 2^(j/4096)
+    return (em1 ? t - 1. : t) + t * p;           // 2^(j/4096) * exp(r)
+}
+
+// exp(x) as double-double. Overflows and underflows outside the interval [dd_exp_min, dd_exp_max]
+ddouble dd_exp(ddouble const x) {
+    if (x.hi != x.hi) return x;                  // NAN
+    if (x.hi > dd_exp_max) return INFINITY;
+    if (x.hi < dd_exp_min) return 0.;
+    int k;
+    ddouble m = dd_exp_core(x, k);
+    return dd_ldexp(m, k);
+}
+
+// exp(x) as long double. The scaling is done in long double precision to avoid 
+// loss of precision for subnormal results
+long double dd_exp_value(ddouble const x) {
+    if (x.hi != x.hi || x.hi > dd_exp_max || x.hi < dd_exp_min) return dd_exp(x).value();
+    int k;
+    ddouble m = dd_exp_core(x, k);
+    long double y = m.value();
+    if (k > 1000)  return y * pow2n(k - 600) * pow2n(600);   // may overflow in double
+    if (k < -1000) return y * pow2n(k + 600) * pow2n(-600);  // subnormal in double
+    return y * pow2n(k);
+}
+
+// exp(x) - 1
+ddouble dd_expm1(ddouble const x) {
+    if (x.hi != x.hi) return x;                  // NAN
+    if (std::fabs(x.hi) <= 8.E-5) return dd_expm1_poly(x);  // avoid loss of precision
+    if (x.hi > 80.) return dd_exp(x);            // 1 is negligible
+    if (x.hi < -80.) return -1.;                 // exp(x) is negligible
+    return dd_exp(x) - 1.;
+}
+
+// natural logarithm. a must be positive
+ddouble dd_log(ddouble const a) {
+    if (a.hi != a.hi || a.hi < 0.) return NAN;
+    if (a.hi == 0.) return -INFINITY;
+    if (!std::isfinite(a.hi)) return a;         // INF
+    ddouble m = a;                               // a = m * 2^e
+    int e = 0;
+    if (a.hi < 1.E-300) {                        // subnormal or near subnormal
+        m = dd_ldexp(m, 600);  e = -600;
+    }
+    union {
+        double f;
+        uint64_t i;
+    } u;
+    u.f = m.hi;
+    int e1 = int(u.i >> 52 & 0x7FF) - 1023;      // exponent
+    if ((u.i & 0x000FFFFFFFFFFFFF) > 0x6A09E667F3BCD) e1++;  // get m in the interval [sqrt(0.5), sqrt(2)]
+    m = dd_ldexp(m, -e1);
+    e += e1;
+    double y0 = std::log(m.hi);                  // first approximation
+    // t = m / exp(y0) - 1 = (m-1)*exp(-y0) + expm1(-y0). 
+    // This is accurate relative to log(m) also when m is close to 1
+    int k;
+    ddouble em = dd_exp_core(-y0, k, true);
+    if (k != 0) em = dd_ldexp(em + 1., k) - 1.;  // k = -1 for y0 > log(2)/4
+    ddouble t = (m - 1.) * (em + 1.) + em;
+    // Newton-Raphson step: log(m) = y0 + log(1+t) = y0 + t - t^2/2
+    ddouble y = ddouble(y0) + (t - 0.5 * t.hi * t.hi);
+    if (e != 0) y = y + dd_ln2 * double(e);
+    return y;
+}
+
+// log(1 + x)
+ddouble dd_log1p(ddouble const x) {
+    if (x.hi == 0. || !std::isfinite(x.hi)) return std::log1p(x.hi);  // +/-0, INF, NAN
+    ddouble u = x + 1.;                          // may be inexact
+    if (!(u.hi > 0.)) return dd_log(u);          // -INF or NAN
+    // log(1+x) = log(u) + log(1 + (x-(u-1))/u)
+    ddouble c = (x - (u - 1.)) * (1. / u.hi);
+    return dd_log(u) + c;
+}
+
+// x^y including special cases
+long double dd_pow(double x, double y) {
+    if (y == 0. || x == 1.) return 1.;
+    if (x != x || y != y) return NAN;
+    double xa = std::fabs(x);
+    bool yinteger = y == std::floor(y);
+    bool yodd = yinteger && std::fabs(y) < 9007199254740992. && std::fmod(y, 2.) != 0.;
+    double sign = (x < 0. || (x == 0. && compare_sign(x, 0.))) && yodd ? -1. : 1.;
+    if (!std::isfinite(y)) {                     // y is +/- INF
+        if (xa == 1.) return 1.;
+        return (xa > 1.) == (y > 0.) ? INFINITY : 0.;
+    }
+    if (x == 0.) return sign * (y > 0. ? 0. : INFINITY);
+    if (xa == INFINITY) return sign * (y > 0. ? INFINITY : 0.);
+    if (x < 0. && !yinteger) return NAN;
+    return sign * dd_exp_value(dd_log(xa) * y);
+}
+
+// cube root
+ddouble dd_cbrt(double x) {
+    if (x == 0. || !std::isfinite(x)) return x;
+    double a = std::fabs(x);
+    int e = std::ilogb(a) / 3;                   // scale a to avoid underflow
+    a = std::ldexp(a, -3 * e);
+    double y0 = std::cbrt(a);                    // first approximation
+    double p, pe;
+    two_prod(y0, y0, p, pe);
+    ddouble r = ddouble(p, pe) * y0 - a;         // y0^3 - a
+    ddouble y = ddouble(y0) - r.hi / (3. * y0 * y0);  // Newton-Raphson step
+    y = dd_ldexp(y, e);
+    return x < 0. ? -y : y;
+}
+
+// hyperbolic functions
+ddouble dd_sinh(double x) {
+    double a = std::fabs(x);
+    ddouble y;
+    if (a != a || a == 0.) return x;
+    if (a < 1.) {                                // sinh = (em + em/(em+1))/2
+        ddouble em = dd_expm1(a);
+        y = (em + em / (em + 1.)) * 0.5;
+    }
+    else if (a > dd_exp_max + 1.) {              // overflow
+        y = INFINITY;
+    }
+    else {                                       // sinh = exp(a)/2 - exp(-a)/2
+        int k;
+        ddouble m = dd_exp_core(ddouble(a) - dd_ln2, k);  // exp(a)/2 = m*2^k
+        y = dd_ldexp(m, k);                      // may overflow
+        if (a < 40.) y = y - dd_ldexp(ddouble(0.25) / m, -k);
+    }
+    return x < 0. ? -y : y;
+}
+
+ddouble dd_cosh(double x) {
+    double a = std::fabs(x);
+    if (a != a) return a;
+    if (a > dd_exp_max + 1.) return INFINITY;    // overflow
+    int k;
+    ddouble m = dd_exp_core(ddouble(a) - dd_ln2, k);  // exp(a)/2 = m*2^k
+    if (a >= 40.) return dd_ldexp(m, k);         // may overflow
+    return dd_ldexp(m, k) + dd_ldexp(ddouble(0.25) / m, -k);
+}
+
+ddouble dd_tanh(double x) {
+    double a = std::fabs(x);
+    ddouble y;
+    if (a != a || a == 0.) return x;
+    if (a > 40.) y = 1.;                         // 1 - tiny
+    else {                                       // tanh = em/(em+2), em = expm1(2a)
+        ddouble em = dd_expm1(2. * a);
+        y = em / (em + 2.);
+    }
+    return x < 0. ? -y : y;
+}
+
+ddouble dd_asinh(double x) {
+    double a = std::fabs(x);
+    ddouble y;
+    if (!std::isfinite(a) || a == 0.) return x;
+    if (a > 1.E150) y = dd_log(a) + dd_ln2;      // a^2 would overflow
+    else {
+        double p, e;
+        two_prod(a, a, p, e);
+        ddouble a2(p, e);                        // a^2
+        ddouble s = dd_sqrt(a2 + 1.);            // sqrt(a^2+1)
+        if (a < 0.5) y = dd_log1p(a2 / (s + 1.) + a);  // log1p(a + a^2/(1+sqrt(a^2+1)))
+        else y = dd_log(s + a);
+    }
+    return x < 0. ? -y : y;
+}
+
+ddouble dd_acosh(double x) {
+    if (x != x || x < 1.) return NAN;
+    if (x == INFINITY) return x;
+    if (x > 1.E150) return dd_log(x) + dd_ln2;   // x^2 would overflow
+    ddouble xm = ddouble(x) - 1.;                // x - 1, exact
+    ddouble xp = ddouble(x) + 1.;                // x + 1, exact
+    return dd_log1p(xm + dd_sqrt(xm * xp));      // log1p(x-1 + sqrt((x-1)(x+1)))
+}
+
+ddouble dd_atanh(double x) {
+    double a = std::fabs(x);
+    ddouble y;
+    if (a != a || a > 1.) return NAN;
+    if (a == 0.) return x;
+    if (a == 1.) y = INFINITY;
+    else {                                       // atanh = log1p(2a/(1-a))/2
+        y = dd_log1p(ddouble(2. * a) / (ddouble(1.) - a)) * 0.5;
+    }
+    return x < 0. ? -y : y;
+}
+
+// reference functions
+#ifdef DD_REFERENCE
+long double ref_exp(double x)   { return dd_exp_value(x); }
+long double ref_expm1(double x) { return dd_expm1(x).value(); }
+long double ref_exp2(double x)  { return dd_exp_value(dd_ln2 * x); }
+long double ref_exp10(double x) { return dd_exp_value(dd_ln10 * x); }
+long double ref_log(double x)   { return dd_log(x).value(); }
+long double ref_log1p(double x) { return dd_log1p(x).value(); }
+long double ref_log2(double x)  { return (dd_log(x) * dd_log2e).value(); }
+long double ref_log10(double x) { return (dd_log(x) * dd_log10e).value(); }
+long double ref_cbrt(double x)  { return dd_cbrt(x).value(); }
+long double ref_pow(double x, double y) { return dd_pow(x, y); }
+long double ref_sinh(double x)  { return dd_sinh(x).value(); }
+long double ref_cosh(double x)  { return dd_cosh(x).value(); }
+long double ref_tanh(double x)  { return dd_tanh(x).value(); }
+long double ref_asinh(double x) { return dd_asinh(x).value(); }
+long double ref_acosh(double x) { return dd_acosh(x).value(); }
+long double ref_atanh(double x) { return dd_atanh(x).value(); }
+#else
+long double ref_exp(double x)   { return expl(x); }
+long double ref_expm1(double x) { return expm1l(x); }
+long double ref_exp2(double x)  { return exp2l(x); }
+long double ref_log(double x)   { return logl(x); }
+long double ref_log1p(double x) { return log1pl(x); }
+long double ref_log2(double x)  { return log2l(x); }
+long double ref_log10(double x) { return log10l(x); }
+long double ref_cbrt(double x)  { return cbrtl(x); }
+long double ref_pow(double x, double y) { return powl(x, y); }
+long double ref_sinh(double x)  { return sinhl(x); }
+long double ref_cosh(double x)  { return coshl(x); }
+long double ref_tanh(double x)  { return tanhl(x); }
+long double ref_asinh(double x) { return asinhl(x); }
+long double ref_acosh(double x) { return acoshl(x); }
+long double ref_atanh(double x) { return atanhl(x); }
+#endif
+
 /************************************************************************
 *
 *                          Test cases
@@ -389,7 +916,7 @@ long double referenceFunction(ST a) {
 
 #elif   testcase == 25       // nan_code, nan_vec
 
-uint32_t a0i;
+thread_local uint32_t a0i;
 inline rtype testFunction(vtype const& a) {
     auto ai = roundi(a);
     a0i = ai[0] & 0x003FFFFF;
@@ -409,7 +936,8 @@ long double referenceFunction(ST a) {
 
 #elif   testcase == 100      // exp
 inline rtype testFunction(vtype const& a) { return exp(a); }
-long double referenceFunction(ST a) { return expl(a); }
+long double referenceFunction(ST a) { return ref_exp(a); }
+#define SCALARFUNC(a) std::exp(a)         // scalar function for benchmark
 #ifdef VECTORMATH_LIB_H
 #define FACCURACY 4          // expected precision
 #else
@@ -422,8 +950,9 @@ long double referenceFunction(ST a) { return expl(a); }
 #elif   testcase == 101      // expm1
 inline rtype testFunction(vtype const& a) { return expm1(a); }
 long double referenceFunction(ST a) { 
-    return expm1l(a); 
+    return ref_expm1(a); 
 }
+#define SCALARFUNC(a) std::expm1(a)       // scalar function for benchmark
 #define FACCURACY 3          // expected precision
 #define MAXF      87.f       // max value for float parameter
 #define MAXD      708.       // max value for double parameter
@@ -431,8 +960,9 @@ long double referenceFunction(ST a) {
 #elif   testcase == 102      // exp2
 inline rtype testFunction(vtype const& a) { return exp2(a); }
 long double referenceFunction(ST a) { 
-    return exp2l(a); 
+    return ref_exp2(a); 
 }
+#define SCALARFUNC(a) std::exp2(a)        // scalar function for benchmark
 #define FACCURACY 3          // expected precision
 #define MAXF      27.f       // max value for float parameter
 #define MAXD      1020.      // max value for double parameter
@@ -440,6 +970,10 @@ long double referenceFunction(ST a) {
 #elif   testcase == 103      // exp10
 inline rtype testFunction(vtype const& a) { return exp10(a); }
 long double referenceFunction(ST a) {
+#define SCALARFUNC(a) std::pow(ST(10), a) // scalar function for benchmark
+#ifdef DD_REFERENCE
+    return ref_exp10(a);
+#else
 #define powLL pow_accurate
     long double y = 1.;
     if (a > 2.) {            // loop calculation for better precision
@@ -457,6 +991,7 @@ long double referenceFunction(ST a) {
         return powLL(10., a+(double)cnt) / y;
     }
     return powLL(10.f, a); 
+#endif
 }
 #define FACCURACY 10         // poor precision in library version
 #define YACCURACY 0
@@ -465,28 +1000,33 @@ long double referenceFunction(ST a) {
 
 #elif   testcase == 104      // log
 inline rtype testFunction(vtype const& a) { return log(a); }
-long double referenceFunction(ST a) { return logl(a); }
+long double referenceFunction(ST a) { return ref_log(a); }
+#define SCALARFUNC(a) std::log(a)         // scalar function for benchmark
 #define FACCURACY 3          // expected precision
 
 #elif   testcase == 105      // log1p
 inline rtype testFunction(vtype const& a) { return log1p(a); }
-long double referenceFunction(ST a) { return log1pl(a); }
+long double referenceFunction(ST a) { return ref_log1p(a); }
+#define SCALARFUNC(a) std::log1p(a)       // scalar function for benchmark
 #define FACCURACY 2          // expected precision
 
 #elif   testcase == 106      // log2
 inline rtype testFunction(vtype const& a) { return log2(a); }
-long double referenceFunction(ST a) { return log2l(a); }
+long double referenceFunction(ST a) { return ref_log2(a); }
+#define SCALARFUNC(a) std::log2(a)        // scalar function for benchmark
 #define FACCURACY 2          // expected precision
 
 #elif   testcase == 107      // log10
 inline rtype testFunction(vtype const& a) { return log10(a); }
-long double referenceFunction(ST a) { return log10l(a); }
+long double referenceFunction(ST a) { return ref_log10(a); }
+#define SCALARFUNC(a) std::log10(a)       // scalar function for benchmark
 #define FACCURACY 3          // expected precision
 
 #elif   testcase == 108      // cube root
 inline rtype testFunction(vtype const& a) { return cbrt(a); }
-long double referenceFunction(ST a) { return cbrtl(a); }
+long double referenceFunction(ST a) { return ref_cbrt(a); }
 
+#define SCALARFUNC(a) std::cbrt(a)        // scalar function for benchmark
 #define FACCURACY 5          // expected precision
 #define MAXF      1.E29      // max value for float parameter
 #define MAXD      1.E200     // max value for double parameter
@@ -517,6 +1057,7 @@ long double referenceFunction(ST x) {
     if ((B & 1) != 0 && (A & 1) != 0 && compare_sign(x0, 0)) y = -y; // get sign of x if A and B odd
     return y;
 }
+#define SCALARFUNC(a) std::pow(a, ST(A) / ST(B))  // scalar function for benchmark
 #define FACCURACY 300        // poor precision in extreme cases
 #define MAXF      1.E20      // max value for float parameter
 #define MAXD      1.E100     // max value for double parameter
@@ -527,7 +1068,8 @@ long double referenceFunction(ST x) {
 
 #elif   testcase == 115      // pow_const(vector, const int)
 inline rtype testFunction(vtype const& a) { return pow_const(a, -3); }
-long double referenceFunction(ST a) { return powl(a, -3); }
+long double referenceFunction(ST a) { return ref_pow(a, -3); }
+#define SCALARFUNC(a) std::pow(a, -3)     // scalar function for benchmark
 #define FACCURACY 5
 
 
@@ -540,7 +1082,13 @@ inline rtype testFunction(vtype const& a) {
 }
 long double referenceFunction(ST a) { 
     if (abs(a) > trig_input_limit) return 0.;
-    return sinl(a); }
+#ifdef TRIG_HARD_CASES
+    return trig_accurate(a, 0);
+#else
+    return sinl(a); 
+#endif
+}
+#define SCALARFUNC(a) std::sin(a)         // scalar function for benchmark
 #define FACCURACY 3          // desired accuracy
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E4       // max value for float parameter
@@ -558,8 +1106,13 @@ inline rtype testFunction(vtype const& a) {
 }
 long double referenceFunction(ST a) { 
     if (abs(a) > trig_input_limit) return 1.;
+#ifdef TRIG_HARD_CASES
+    return trig_accurate(a, 1);
+#else
     return cosl(a); 
+#endif
 }
+#define SCALARFUNC(a) std::cos(a)         // scalar function for benchmark
 #define FACCURACY 4          // desired accuracy
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E4       // max value for float parameter
@@ -578,8 +1131,13 @@ inline rtype testFunction(vtype const& a) {
 }
 long double referenceFunction(ST a) { 
     if (abs(a) > trig_input_limit) return 0.;
+#ifdef TRIG_HARD_CASES
+    return trig_accurate(a, 0);
+#else
     return sinl(a); 
+#endif
 }
+#define SCALARFUNC(a) std::sin(a)         // scalar function for benchmark
 #define FACCURACY 4          // desired accuracy
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E4       // max value for float parameter
@@ -599,8 +1157,13 @@ inline rtype testFunction(vtype const& a) {
 }
 long double referenceFunction(ST a) { 
     if (abs(a) > trig_input_limit) return 1.;
+#ifdef TRIG_HARD_CASES
+    return trig_accurate(a, 1);
+#else
     return cosl(a); 
+#endif
 }
+#define SCALARFUNC(a) std::cos(a)         // scalar function for benchmark
 #define FACCURACY 4          // desired accuracy
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E4       // max value for float parameter
@@ -618,8 +1181,13 @@ inline rtype testFunction(vtype const& a) {
 }
 long double referenceFunction(ST a) { 
     if (abs(a) > trig_input_limit) return 0.;
+#ifdef TRIG_HARD_CASES
+    return trig_accurate(a, 2);
+#else
     return std::tan((long double)a); 
+#endif
 }
+#define SCALARFUNC(a) std::tan(a)         // scalar function for benchmark
 #define FACCURACY 4          // desired accuracy
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E4       // max value for float parameter
@@ -634,6 +1202,7 @@ long double referenceFunction(ST a) {
 #elif   testcase == 205      // asin
 inline rtype testFunction(vtype const& a) { return asin(a); }
 long double referenceFunction(ST a) { return asinl(a); }
+#define SCALARFUNC(a) std::asin(a)        // scalar function for benchmark
 #define FACCURACY 3          // desired accuracy
 #define MAXF      1.         // max value for float parameter
 #define MAXD      1.         // max value for double parameter
@@ -641,6 +1210,7 @@ long double referenceFunction(ST a) { return asinl(a); }
 #elif   testcase == 206      // acos
 inline rtype testFunction(vtype const& a) { return acos(a); }
 long double referenceFunction(ST a) { return acosl(a); }
+#define SCALARFUNC(a) std::acos(a)        // scalar function for benchmark
 #define FACCURACY 3          // desired accuracy
 #define MAXF      1.         // max value for float parameter
 #define MAXD      1.         // max value for double parameter
@@ -648,6 +1218,7 @@ long double referenceFunction(ST a) { return acosl(a); }
 #elif   testcase == 207      // atan
 inline rtype testFunction(vtype const& a) { return atan(a); }
 long double referenceFunction(ST a) { return atanl(a); }
+#define SCALARFUNC(a) std::atan(a)        // scalar function for benchmark
 #define FACCURACY 3          // desired accuracy
 
 #elif   testcase == 210      // sinpi
@@ -662,6 +1233,7 @@ long double referenceFunction(ST a) {
     long double a2 = a - 2. * ai;
     return sinl(a2*pi_long); 
 }
+#define SCALARFUNC(a) std::sin(a * ST(3.14159265358979323846))  // scalar function for benchmark
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E10      // max value for float parameter
 #define MAXD      1.E15      // max value for double parameter
@@ -684,6 +1256,7 @@ long double referenceFunction(ST a) {
     long double ai = roundl(0.5 * a);
     long double a2 = a - 2. * ai;
     return cosl(a2*pi_long); }
+#define SCALARFUNC(a) std::cos(a * ST(3.14159265358979323846))  // scalar function for benchmark
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E10       // max value for float parameter
 #define MAXD      1.E15       // max value for double parameter
@@ -706,6 +1279,7 @@ long double referenceFunction(ST a) {
     long double a2 = a - 2. * ai;
     return sinl(a2 * pi_long);
 }
+#define SCALARFUNC(a) std::sin(a * ST(3.14159265358979323846))  // scalar function for benchmark
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E10       // max value for float parameter
 #define MAXD      1.E10       // max value for double parameter
@@ -729,6 +1303,7 @@ long double referenceFunction(ST a) {
     long double ai = roundl(0.5 * a);
     long double a2 = a - 2. * ai;
     return cosl(a2*pi_long); }
+#define SCALARFUNC(a) std::cos(a * ST(3.14159265358979323846))  // scalar function for benchmark
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E10       // max value for float parameter
 #define MAXD      1.E10       // max value for double parameter
@@ -761,6 +1336,7 @@ long double referenceFunction(ST a) {
     long double r = tanl(a2*pi_long);
     return r;
 }
+#define SCALARFUNC(a) std::tan(a * ST(3.14159265358979323846))  // scalar function for benchmark
 #if INSTRSET < 8  // lower overflow limit without FMA
 #define MAXF      1.E4        // max value for float parameter
 #define MAXD      1.E10       // max value for double parameter
@@ -778,7 +1354,8 @@ long double referenceFunction(ST a) {
 
 #elif   testcase == 300      // sinh
 inline rtype testFunction(vtype const& a) { return sinh(a); }
-long double referenceFunction(ST a) { return sinhl(a); }
+long double referenceFunction(ST a) { return ref_sinh(a); }
+#define SCALARFUNC(a) std::sinh(a)        // scalar function for benchmark
 #define FACCURACY 2          // desired accuracy
 #define MAXF      88         // max value for float parameter
 #define MAXD      709        // max value for double parameter
@@ -786,32 +1363,37 @@ long double referenceFunction(ST a) { return sinhl(a); }
 #elif   testcase == 301      // cosh
 inline rtype testFunction(vtype const& a) { return cosh(a); }
 long double referenceFunction(ST a) { 
-    return coshl(a);         // avoid -INF return
+    return ref_cosh(a);      // avoid -INF return
 }
 //#define IGNORE_INF_SIGN    // why do I see coshl(-INF) = -INF?
+#define SCALARFUNC(a) std::cosh(a)        // scalar function for benchmark
 #define FACCURACY 2          // desired accuracy
 #define MAXF      88         // max value for float parameter
 #define MAXD      709        // max value for double parameter
 
 #elif   testcase == 302      // tanh
 inline rtype testFunction(vtype const& a) { return tanh(a); }
-long double referenceFunction(ST a) { return tanhl(a); }
+long double referenceFunction(ST a) { return ref_tanh(a); }
+#define SCALARFUNC(a) std::tanh(a)        // scalar function for benchmark
 #define FACCURACY 2          // desired accuracy
 
 #elif   testcase == 303      // asinh
 inline rtype testFunction(vtype const& a) { return asinh(a); }
-long double referenceFunction(ST a) { return asinhl(a); }
+long double referenceFunction(ST a) { return ref_asinh(a); }
+#define SCALARFUNC(a) std::asinh(a)       // scalar function for benchmark
 #define FACCURACY 3          // desired accuracy
 
 #elif   testcase == 304      // acosh
 inline rtype testFunction(vtype const& a) { return acosh(a); }
-long double referenceFunction(ST a) { return acoshl(a); }
+long double referenceFunction(ST a) { return ref_acosh(a); }
+#define SCALARFUNC(a) std::acosh(a)       // scalar function for benchmark
 #define FACCURACY 3          // desired accuracy
 #define USE_ABSOLUTE_ERROR   // acosh(1) = 0 +/- small error
 
 #elif   testcase == 305      // atanh
 inline rtype testFunction(vtype const& a) { return atanh(a); }
-long double referenceFunction(ST a) { return atanhl(a); }
+long double referenceFunction(ST a) { return ref_atanh(a); }
+#define SCALARFUNC(a) std::atanh(a)       // scalar function for benchmark
 #define FACCURACY 2          // desired accuracy
 #define MAXF      1.25       // max value for float parameter
 #define MAXD      1.25       // max value for double parameter
@@ -830,6 +1412,7 @@ inline rtype testFunction(vtype & a, vtype & b) {
 }
 long double referenceFunction(ST a, ST b) { 
     return pow_accurate(a, b); }
+#define SCALARFUNC(a, b) std::pow(a, b)   // scalar function for benchmark
 #define FACCURACY 2
 #define YACCURACY 0.6        // accuracy relative to second parameter
 // The high error is in the reference library on Gnu and Clang in double precision. 
@@ -839,7 +1422,7 @@ long double referenceFunction(ST a, ST b) {
 #define TWO_PARAMETERS       // has two parameters
 
 #elif   testcase == 501      // pow(vector,scalar)
-ST b0;
+thread_local ST b0;
 inline rtype testFunction(vtype const& a, vtype & b) { 
     b0 = b[0];
     b = b0;  // reset b for the sake of YACCURACY 
@@ -847,6 +1430,7 @@ inline rtype testFunction(vtype const& a, vtype & b) {
 }
 long double referenceFunction(ST a, ST b) { 
     return pow_accurate(a, b0); }
+#define SCALARFUNC(a, b) std::pow(a, b)   // scalar function for benchmark
 #define FACCURACY 2
 #define YACCURACY 0.6        // accuracy relative to second parameter
 #define MAXF      1.E7       // max value for float parameter
@@ -854,7 +1438,7 @@ long double referenceFunction(ST a, ST b) {
 #define TWO_PARAMETERS       // has two parameters
 
 #elif   testcase == 502      // pow(vector,int)
-int bi0;
+thread_local int bi0;
 inline rtype testFunction(vtype const& a, vtype & b) { 
     bi0 = int(b[0]);
     if (bi0 == 0x80000000) bi0--;  // avoid integer overflow
@@ -862,6 +1446,7 @@ inline rtype testFunction(vtype const& a, vtype & b) {
     return pow(a, bi0); }
 long double referenceFunction(ST a, ST b) { 
     return pow_accurate(a, (double)bi0); }
+#define SCALARFUNC(a, b) std::pow(a, int(b))  // scalar function for benchmark
 #define FACCURACY 2
 #define YACCURACY 0.8        // accuracy relative to second parameter
 #define MAXF      1.E6       // max value for float parameter
@@ -874,6 +1459,7 @@ inline rtype testFunction(vtype const& a, vtype const& b) {
     return atan2(a, b); 
 }
 long double referenceFunction(ST a, ST b) { return atan2l(a, b); }
+#define SCALARFUNC(a, b) std::atan2(a, b) // scalar function for benchmark
 #define FACCURACY 3          // desired accuracy
 #define TWO_PARAMETERS       // has two parameters
 
@@ -886,6 +1472,7 @@ long double referenceFunction(ST a, ST b) {
     if (compare_sign(a,b)) return 0;   // +0 and -0
     return a;    
 }
+#define SCALARFUNC(a, b) std::fmax(a, b)  // scalar function for benchmark
 #define FACCURACY 0          // desired accuracy
 #define TWO_PARAMETERS       // has two parameters
 
@@ -898,6 +1485,7 @@ long double referenceFunction(ST a, ST b) {
     if (compare_sign(a,b)) return -0.f;   // +0 and -0
     return a;    
 }
+#define SCALARFUNC(a, b) std::fmin(a, b)  // scalar function for benchmark
 #define FACCURACY 0          // desired accuracy
 #define TWO_PARAMETERS       // has two parameters
 
@@ -942,7 +1530,8 @@ uint32_t compare_sign(double a, double b) {
 // The powl function under WSL v. 1 is terribly inaccurate if you don't fix the FP control word
 // The powl function under Mingw64 is also somewhat inaccurate.
 // MS Visual Studio has no long double
-// Make a more accurate version of powl if needed:
+// Make a more accurate version of powl if needed.
+// ref_pow uses double-double arithmetic unless LONGDOUBLE_REFERENCE is defined:
 
 long double pow_accurate(double x, double y) {
 #if false // (defined(__GNUC__) || defined(__clang__)) && !defined(__INTEL_COMPILER) 
@@ -983,7 +1572,7 @@ long double pow_accurate(double x, double y) {
 }
 
 #else  // MS or Intel compilers
-    return powl(x,y);
+    return ref_pow(x,y);
 }
 #endif
 #endif
@@ -995,6 +1584,7 @@ long double pow_accurate(double x, double y) {
 
 const int maxerrors = 20;         // maximum errors to report
 int numerr = 0;                   // count errors
+std::mutex printMutex;            // prevent threads from mixing error reports
 
 // type-specific load function
 template <typename T, typename E>
@@ -1155,6 +1745,179 @@ ranGen ran(seed);
 
 
 
+
+// ----------------------------------------------------------------------------
+//         Range reduction of trigonometric functions with double-double arithmetic
+// ----------------------------------------------------------------------------
+
+// pi/2 split into four parts
+const double pio2_1 = 1.5707963267948966;        // 0x1.921fb54442d18p+0
+const double pio2_2 = 6.123233995736766e-17;     // 0x1.1a62633145c07p-54
+const double pio2_3 = -1.4973849048591698e-33;   // -0x1.f1976b7ed8fbcp-110
+const double pio2_4 = 5.562271104316826e-50;     // 0x1.4cf98e804177dp-164
+
+// calculate x - k*pi/2 with double-double precision. k must be an integer close to x/(pi/2).
+// The absolute error is approximately |x| * 2^-160
+ddouble reduce_pio2(double x, double k) {
+    double p1, e1, p2, e2, p3, e3;
+    two_prod(k, pio2_1, p1, e1);
+    two_prod(k, pio2_2, p2, e2);
+    two_prod(k, pio2_3, p3, e3);
+    ddouble r = x - p1;                          // exact because x is close to p1
+    r = r - e1;
+    r = r - p2;
+    r = r - e2;
+    r = r - p3;
+    r = r - (e3 + k * pio2_4);
+    return r;
+}
+
+// accurate sin (func = 0), cos (func = 1), or tan (func = 2), also for x close to k*pi/2
+long double trig_accurate(double x, int func) {
+    double k = std::nearbyint(x * 0.63661977236758134);  // x / (pi/2)
+    long double r = reduce_pio2(x, k).value();   // |r| <= pi/4 approximately
+    int q = int(std::fmod(k, 4.));               // quadrant
+    if (q < 0) q += 4;
+    switch (func) {
+    case 0:  // sin
+        switch (q) {
+        case 0: return sinl(r);
+        case 1: return cosl(r);
+        case 2: return -sinl(r);
+        default: return -cosl(r);
+        }
+    case 1:  // cos
+        switch (q) {
+        case 0: return cosl(r);
+        case 1: return -sinl(r);
+        case 2: return -cosl(r);
+        default: return sinl(r);
+        }
+    default: // tan
+        if (q & 1) return -1.L / tanl(r);
+        return tanl(r);
+    }
+}
+
+
+#ifdef TRIG_HARD_CASES
+// ----------------------------------------------------------------------------
+//         Hard cases for range reduction of trigonometric functions
+// ----------------------------------------------------------------------------
+#if testcase < 200 || testcase > 214 || (testcase > 204 && testcase < 210)
+#error TRIG_HARD_CASES is only for trigonometric functions with range reduction
+#endif
+#ifdef BUCKET_SAMPLES
+#error TRIG_HARD_CASES and BUCKET_SAMPLES cannot be combined
+#endif
+#ifndef HARD_SEARCH
+#define HARD_SEARCH 0x400000      // number of random k to search for the hardest cases
+#endif
+#undef USE_ABSOLUTE_ERROR         // relative error is needed for results near zero
+// The reference is accurate to long double precision only for inputs farther than this
+// from k*pi/2, in units of the last place of a double input. See reduce_pio2
+const double hardLimit = 5.7E-14;  // 2^-44
+
+#if testcase >= 210               // sinpi, cospi, etc: hard cases near k/2
+const double hardPeriod = 0.5;
+#else                             // sin, cos, etc: hard cases near k*pi/2
+const double hardPeriod = pio2_1;
+#endif
+
+// floating point number of type T nearest to k*pi/2 or k/2
+template <typename T>
+T hardPoint(double k) {
+    if (hardPeriod == 0.5) return T(k * 0.5);
+    double p1, e1;
+    two_prod(k, pio2_1, p1, e1);
+    return T(p1 + (e1 + k * pio2_2));
+}
+
+// distance from x to k*pi/2 or k/2 in units of the last place of x
+template <typename T>
+double hardDistance(T x, double k) {
+    if (hardPeriod == 0.5) return std::fabs(double(x) - k * 0.5) / delta_unit(x);
+    ddouble r = reduce_pio2(x, k);
+    return std::fabs(r.hi + r.lo) / delta_unit(x);
+}
+
+// make list of hard inputs. Returns number of inputs
+template <typename T>
+int makeTrigHardCases(T * list, int n) {
+    const int mantissaBits = sizeof(T) > 4 ? 53 : 24;
+    double m = sizeof(T) > 4 ? (double)MAXD : (double)MAXF;  // max input
+    if (m > trig_input_limit) m = trig_input_limit;  // reference function is not valid above this limit
+    if (m > std::ldexp(1., mantissaBits)) m = std::ldexp(1., mantissaBits);  // all bigger values are integers
+    double kmax = std::floor(m / hardPeriod);
+    double logkmax = std::log2(kmax);
+    int i = 0, j;
+    double k;
+    // first half: k log-uniform in [1, kmax]. The nearest input and the neighbor on the other side
+    // (all inputs for the *pi functions, where the nearest input is exact)
+    int nspread = hardPeriod == 0.5 ? n : n / 2;
+    while (i < nspread) {
+        k = std::floor(std::exp2(get_random<double>(ran) * logkmax));
+        T x = hardPoint<T>(k);
+        T y;                                     // neighbor on the other side of k*pi/2
+        if (hardPeriod == 0.5) {
+            y = std::nextafter(x, T(-1.E30));
+            x = std::nextafter(x, T(1.E30));
+        }
+        else {
+            y = std::nextafter(x, double(x) < k * hardPeriod ? T(1.E30) : T(-1.E30));
+        }
+        bool negative = (i & 2) != 0;            // alternate signs
+        list[i++] = negative ? -x : x;
+        if (i < nspread) list[i++] = negative ? -y : y;
+    }
+    // second half: the hardest cases found. All k if kmax is small, otherwise random k
+    typedef std::pair<double, T> Candidate;      // distance, input
+    std::priority_queue<Candidate> best;         // max heap of the best candidates
+    int nbest = n - nspread;
+    bool all = kmax <= HARD_SEARCH;
+    double numk = all ? kmax : HARD_SEARCH;
+    for (j = 1; nbest > 0 && j <= numk; j++) {
+        k = all ? double(j) : std::floor(std::exp2(get_random<double>(ran) * logkmax));
+        T x = hardPoint<T>(k);
+        double d = hardDistance(x, k);
+        if ((int)best.size() < nbest) best.push(Candidate(d, x));
+        else if (d < best.top().first) {
+            best.pop();
+            best.push(Candidate(d, x));
+        }
+    }
+    double mindist = 0;  T minx = 0;
+    while (!best.empty()) {
+        mindist = best.top().first;  minx = best.top().second;
+        list[i] = (i & 1) ? -minx : minx;
+        i++;
+        best.pop();
+    }
+    printf("\nHard cases for %s: %i inputs near k*%s, k up to %.0f", 
+        INSTRSET >= 8 ? "FMA" : "no FMA", i, hardPeriod == 0.5 ? "1/2" : "pi/2", kmax);
+    if (nbest > 0) {
+        printf(", %s searched\nSmallest distance %.3G ULP at x = %.17G", 
+            all ? "all k" : "random k", mindist, (double)minx);
+        if (sizeof(T) > 4 && hardPeriod != 0.5 && mindist < hardLimit) {
+            printf("\nWarning: distance below %.3G ULP. The reference may be inaccurate", hardLimit);
+        }
+    }
+    return i;
+}
+#endif  // TRIG_HARD_CASES
+
+#ifdef BUCKET_SAMPLES
+#ifndef HEATMAP
+#define HEATMAP                                  // sampling by exponent implies heat map report
+#endif
+#ifndef EXPONENT_MIN
+#define EXPONENT_MIN  (sizeof(ST) > 4 ? -1023 : -127)  // zero and subnormal
+#endif
+#ifndef EXPONENT_MAX
+#define EXPONENT_MAX  (sizeof(ST) > 4 ? 1024 : 128)    // INF and NAN
+#endif
+#endif
+
 // template to generate list of testdata
 template <typename T>
 class TestData {
@@ -1162,13 +1925,39 @@ public:
     enum LS {
         // define array size. Must be a multiple of vector size:
 #ifdef TWO_PARAMETERS
-        listsize = 0x100
+        listsize = 0x100,
 #else
-        listsize = 0x1000
+        listsize = 0x1000,
+#endif
+#ifdef BUCKET_SAMPLES
+        // BUCKET_SAMPLES inputs for each sign and exponent, rounded up to a multiple of 16
+        samplesize = (2 * (EXPONENT_MAX - EXPONENT_MIN + 1) * BUCKET_SAMPLES + 15) & -16,
+        maxsize = samplesize > listsize ? samplesize : listsize
+#elif defined(TRIG_HARD_CASES)
+        // TRIG_HARD_CASES inputs, rounded up to a multiple of 16
+        hardsize = (TRIG_HARD_CASES + 15) & -16,
+        maxsize = hardsize > listsize ? hardsize : listsize
+#else
+        maxsize = listsize
 #endif
     };
-    TestData() {                                 // constructor
+    // constructor. firstParameter = true for special test data if BUCKET_SAMPLES 
+    // or TRIG_HARD_CASES defined
+    TestData(bool firstParameter = false) {
         int i, j;                                // loop counter
+        num = listsize;
+#ifdef BUCKET_SAMPLES
+        if (firstParameter) {
+            makeBucketSamples();
+            return;
+        }
+#endif
+#ifdef TRIG_HARD_CASES
+        if (firstParameter) {
+            num = makeTrigHardCases(list, hardsize);
+            return;
+        }
+#endif
         // floating point type
         // fill sequential data into array
         for (i = 0; i < 20; i++) {
@@ -1238,30 +2027,68 @@ public:
             list[i] = get_random<T>(ran) * scale;
         }
     }
-    T list[listsize];                            // array of test data
+#ifdef BUCKET_SAMPLES
+    // make BUCKET_SAMPLES random inputs for each sign and binary exponent
+    void makeBucketSamples() {
+        const int bias = sizeof(T) > 4 ? 1023 : 127;
+        T m = sizeof(T) > 4 ? (T)MAXD : (T)MAXF; // maximum parameter
+        int e, s, j;                             // loop counters
+        num = 0;
+        for (e = EXPONENT_MIN; e <= EXPONENT_MAX; e++) {
+            if (e > -bias && e < bias + 1 && std::ldexp(T(1), e) > m) continue; // bucket too big
+            for (s = 0; s < 2; s++) {
+                for (j = 0; j < BUCKET_SAMPLES; j++) {
+                    T x;
+                    if (e == -bias) {            // zero or subnormal
+                        x = j == 0 ? T(0) : ldexp(get_random<T>(ran), 1 - bias);
+                    }
+                    else if (e == bias + 1) {    // INF or NAN
+                        if constexpr (sizeof(T) > 4) {
+                            x = j == 0 ? (T)bit_castd(0x7FF0000000000000) : 
+                                (T)bit_castd(0x7FF0000000000000 | (get_random<uint64_t>(ran) >> 12 | 1));
+                        }
+                        else {
+                            x = j == 0 ? bit_castf(0x7F800000) : bit_castf(0x7F800000 | (ran.next() >> 9 | 1));
+                        }
+                    }
+                    else {                       // normal number in [2^e, min(2^(e+1), m)]
+                        T lo = std::ldexp(T(1), e);
+                        T hi = 2 * lo < m ? 2 * lo : m;
+                        x = lo + get_random<T>(ran) * (hi - lo);
+                    }
+                    list[num++] = s ? -x : x;
+                }
+            }
+        }
+        // fill last vector with copies of the first inputs
+        for (j = 0; num % 16 != 0; j++) list[num++] = list[j];
+    }
+#endif
+    T list[maxsize];                             // array of test data
+    int num;                                     // number of inputs in list
     int size() {                                 // get list size
-        return listsize;
+        return num;
     }
 };
 
 
-// get value of least significant bit
+// get value of least significant bit.
+// This is calculated from the exponent bits because it must be fast in exhaustive tests
 float delta_unit(float x) {
     union {
         float f;
         uint32_t i;
     } u;
-    x = std::fabs(x);
-    Vec4f xv = Vec4f(x);
-    if (!(is_finite(xv)[0])) return 1.f;
-    if (x == 0.f || is_subnormal(xv)[0]) {
-        u.i = 0x00800000;  // smallest positive normal number
+    u.f = x;
+    uint32_t e = (u.i >> 23) & 0xFF;   // biased exponent
+    if (e == 0xFF) return 1.f;         // INF or NAN
+    if (e == 0) {                      // zero or subnormal
+        u.i = 0x00800000;              // smallest positive normal number
         return u.f;
     }
-    float x1 = x;
-    u.f = x;
-    u.i++;
-    return u.f - x1;
+    if (e > 23) u.i = (e - 23) << 23;  // 2^(exponent-23)
+    else u.i = 1u << (e - 1);          // subnormal delta
+    return u.f;
 }
 
 double delta_unit(double x) {
@@ -1269,17 +2096,16 @@ double delta_unit(double x) {
         double f;
         uint64_t i;
     } u;
-    x = std::fabs(x);
-    Vec2d xv = Vec2d(x);
-    if (!(is_finite(xv)[0])) return 1.;
-    if (x == 0. || is_subnormal(xv)[0]) {
-        u.i = 0x0010000000000000;  // smallest positive normal number
+    u.f = x;
+    uint64_t e = (u.i >> 52) & 0x7FF;  // biased exponent
+    if (e == 0x7FF) return 1.;         // INF or NAN
+    if (e == 0) {                      // zero or subnormal
+        u.i = 0x0010000000000000;      // smallest positive normal number
         return u.f;
     }
-    double x1 = x;
-    u.f = x;
-    u.i++;
-    return u.f - x1;
+    if (e > 52) u.i = (e - 52) << 52;  // 2^(exponent-52)
+    else u.i = uint64_t(1) << (e - 1); // subnormal delta
+    return u.f;
 }
 
 
@@ -1387,27 +2213,14 @@ inline double compare_vectors(T const& a, T const& b) {
     return dif;
 }
 
-// report if error
+// check if an error should be ignored. Does not print anything
 template <typename T, typename R>
-bool errorreport(int i, int k, T const a, R const r, long double const e) {
+bool ignoreError(T const a, R const r, long double const e) {
     bool ignore = false;  // error should not be reported as serious
     bool signerror;       // signed zero has wrong sign
-    if (numerr == 0) {
-        printf("\ntest case %i:", testcase);
-    }
-    printf("\nError at %i,%i: ", i, k);
     bool different = (double)r != (double)e;
     signerror = compare_sign((double)r, (double)e) != 0;
     different &= !(r != r && e != e); // both are NAN    
-    if (different || signerror) {
-        printVal(a);
-        printf(" -> ");
-        printVal(r);
-        printf(" != ");
-        printVal((R)e);
-        printf(" diff = ");
-        printf("%.2G", r!=e ? compare_scalars(r, e) : 0);
-    }
 #ifdef USE_ABSOLUTE_ERROR
     if constexpr (sizeof(T) < 8) {   // float
         if (std::fabs(a) < 5.E-38) ignore = true;
@@ -1429,10 +2242,48 @@ bool errorreport(int i, int k, T const a, R const r, long double const e) {
 #ifdef IGNORE_NAN
     if (r != r || e != e) ignore = true;
 #endif
+    return ignore;
+}
+
+// report if error
+template <typename T, typename R>
+bool errorreport(int i, int k, T const a, R const r, long double const e) {
+    if (numerr == 0) {
+        printf("\ntest case %i:", testcase);
+    }
+    printf("\nError at %i,%i: ", i, k);
+    bool different = (double)r != (double)e;
+    bool signerror = compare_sign((double)r, (double)e) != 0;
+    different &= !(r != r && e != e); // both are NAN    
+    if (different || signerror) {
+        printVal(a);
+        printf(" -> ");
+        printVal(r);
+        printf(" != ");
+        printVal((R)e);
+        printf(" diff = ");
+        printf("%.2G", r!=e ? compare_scalars(r, e) : 0);
+    }
+    bool ignore = ignoreError(a, r, e);
     if (ignore) printf(" ignored");
     return ignore;
 }
 
+// check if an error should be ignored. two parameters. Does not print anything
+template <typename T, typename R>
+bool ignoreError(T const a, T const b, R const r, long double const e) {
+    bool ignore = false;  // error should not be reported as serious
+#ifdef USE_ABSOLUTE_ERROR
+    if (sizeof(T) < 8) {   // float
+        if (std::fabs(a) < 5.E-38) ignore = true;
+    }
+    else {                 // double
+        if (std::fabs(a) < 1.E-307) ignore = true;
+    }
+#endif
+    return ignore;
+}
+
 // report if error. two parameters
 template <typename T, typename R>
 bool errorreport(int i, int j, int k, T const a, T const b, R const r, long double const e) {
@@ -1453,28 +2304,1096 @@ bool errorreport(int i, int j, int k, T const a, T const b, R const r, long doub
         printf(" diff = ");
         printf("%.2G", r!=e ? compare_scalars(r, e) : 0);
     }
-#ifdef USE_ABSOLUTE_ERROR
-    if (sizeof(T) < 8) {   // float
-        if (std::fabs(a) < 5.E-38) ignore = true;
+    ignore = ignoreError(a, b, r, e);
+    if (ignore) printf(" ignored");
+    return ignore;
+}
+
+
+// ----------------------------------------------------------------------------
+//             Error statistics: histogram and list of worst inputs
+// ----------------------------------------------------------------------------
+#ifndef TOPK
+#define TOPK 10                   // number of worst inputs to keep
+#endif
+#if !defined(ERROR_STATISTICS) && (defined(STATFILE) || defined(EXHAUSTIVE_TEST) \
+    || defined(HEATMAP) || defined(GRID_TEST) || defined(DENORMAL_TEST))
+#define ERROR_STATISTICS          // statistics file specified or implied by test mode
+#endif
+#ifndef STATFILE
+#define STATFILE "errorstat.csv"  // file for error statistics
+#endif
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
+// Histogram of errors and list of the TOPK worst inputs. 
+// Each thread has its own instance. Instances are combined with merge()
+class ErrorStatistics {
+public:
+    enum {
+        binExact = 0,             // result equals rounded reference
+        binSign = 12,             // wrong sign of zero, or NAN error
+        binIgnored = 13,          // error ignored
+        numBins = 14              // bins 1-11: <= 0.5, <= 1, <= 2, <= 4, ... <= 256, > 256 ULP
+    };
+    struct Worst {                // description of a bad result
+        double dif;               // error in ULP
+        double a, b;              // input parameters
+        double r;                 // result
+        long double e;            // reference value
+    };
+    uint64_t bins[numBins];       // histogram
+    uint64_t count;               // number of results
+    double sum;                   // sum of errors, for mean
+    double maxdif;                // maximum error
+    Worst worst[TOPK];            // worst results, sorted
+    int numworst;                 // number of entries in worst
+#ifdef HEATMAP
+    // statistics for each sign and biased exponent of first input
+    enum {
+        numExponents = sizeof(ST) > 4 ? 2048 : 256,
+        numBuckets = 2 * numExponents
+    };
+    uint64_t bucketCount[numBuckets];  // number of results
+    uint64_t bucketValid[numBuckets];  // number of results not ignored and without sign error
+    double bucketSum[numBuckets];      // sum of errors
+    double bucketMax[numBuckets];      // maximum error
+#endif
+    ErrorStatistics() {
+        for (int i = 0; i < numBins; i++) bins[i] = 0;
+        count = 0;  sum = 0;  maxdif = 0;  numworst = 0;
+#ifdef HEATMAP
+        for (int i = 0; i < numBuckets; i++) {
+            bucketCount[i] = bucketValid[i] = 0;  bucketSum[i] = bucketMax[i] = 0;
+        }
+#endif
     }
-    else {                 // double
-        if (std::fabs(a) < 1.E-307) ignore = true;
+    // get histogram bin for error that is not exact, ignored, or sign error
+    static int binIndex(double dif) {
+        if (dif <= 0.5) return 1;
+        if (dif <= 1.) return 2;
+        int ex;                   // bin = 2 + ceil(log2(dif))
+        double m = frexp(dif, &ex);
+        if (m == 0.5) ex--;
+        return ex > 9 ? 11 : 2 + ex;
+    }
+#ifdef HEATMAP
+    // get bucket index from sign and exponent bits of input
+    static int bucketIndex(double a) {
+        ST x = (ST)a;
+        if constexpr (sizeof(ST) > 4) {
+            uint64_t u;
+            memcpy(&u, &x, 8);
+            return int(u >> 52);  // sign and biased exponent
+        }
+        else {
+            uint32_t u;
+            memcpy(&u, &x, 4);
+            return int(u >> 23);  // sign and biased exponent
+        }
     }
 #endif
-    if (ignore) printf(" ignored");
-    return ignore;
+    // add one result. ignore = true if error is ignored
+    void add(double dif, bool ignore, double a, double b, double r, long double e) {
+        count++;
+#ifdef HEATMAP
+        int bucket = bucketIndex(a);
+        bucketCount[bucket]++;
+        if (!ignore && dif >= 0.) {
+            bucketValid[bucket]++;
+            bucketSum[bucket] += dif;
+            if (dif > bucketMax[bucket]) bucketMax[bucket] = dif;
+        }
+#endif
+        if (ignore) {
+            bins[binIgnored]++;
+            return;
+        }
+        if (!(dif >= 0.)) {       // negative for sign error, or NAN
+            bins[binSign]++;
+            return;
+        }
+        if (dif == 0.) {
+            bins[binExact]++;
+            return;
+        }
+        sum += dif;
+        bins[binIndex(dif)]++;
+        if (dif > maxdif) maxdif = dif;
+        if (numworst < TOPK || dif > worst[TOPK-1].dif) {
+            // insert in sorted list of worst results
+            int i = numworst < TOPK ? numworst++ : TOPK - 1;
+            for (; i > 0 && worst[i-1].dif < dif; i--) worst[i] = worst[i-1];
+            worst[i].dif = dif;  worst[i].a = a;  worst[i].b = b;  worst[i].r = r;  worst[i].e = e;
+        }
+    }
+    // combine with statistics from another thread
+    void merge(ErrorStatistics const & other) {
+        for (int i = 0; i < numBins; i++) bins[i] += other.bins[i];
+        count += other.count;
+        sum += other.sum;
+        if (other.maxdif > maxdif) maxdif = other.maxdif;
+#ifdef HEATMAP
+        for (int i = 0; i < numBuckets; i++) {
+            bucketCount[i] += other.bucketCount[i];
+            bucketValid[i] += other.bucketValid[i];
+            bucketSum[i] += other.bucketSum[i];
+            if (other.bucketMax[i] > bucketMax[i]) bucketMax[i] = other.bucketMax[i];
+        }
+#endif
+        for (int j = 0; j < other.numworst; j++) {
+            Worst const & w = other.worst[j];
+            if (numworst < TOPK || w.dif > worst[TOPK-1].dif) {
+                int i = numworst < TOPK ? numworst++ : TOPK - 1;
+                for (; i > 0 && worst[i-1].dif < w.dif; i--) worst[i] = worst[i-1];
+                worst[i] = w;
+            }
+        }
+    }
+    // mean error of results that are not ignored
+    double mean() const {
+        uint64_t n = count - bins[binIgnored] - bins[binSign];
+        return n ? sum / double(n) : 0.;
+    }
+    static const char * binName(int i) {
+        static const char * names[numBins] = {
+            "exact", "<=0.5", "<=1", "<=2", "<=4", "<=8", "<=16", "<=32", "<=64", "<=128", "<=256", ">256", 
+            "sign/nan", "ignored" };
+        return names[i];
+    }
+    // print histogram and worst results
+    void print() const {
+        const int digits = sizeof(ST) > 4 ? 17 : 9;  // precision of input
+        printf("\nError histogram for %llu results, mean %.3G ULP, max %.3G ULP:", 
+            (unsigned long long)count, mean(), maxdif);
+        for (int i = 0; i < numBins; i++) {
+            if (bins[i]) printf("\n%9s ULP: %12llu  %8.4f%%", binName(i), 
+                (unsigned long long)bins[i], 100. * double(bins[i]) / double(count));
+        }
+        if (numworst) printf("\nWorst results:");
+        for (int i = 0; i < numworst; i++) {
+            printf("\n%8.4G ULP: x = %.*G", worst[i].dif, digits, worst[i].a);
+#ifdef TWO_PARAMETERS
+            printf(", y = %.*G", digits, worst[i].b);
+#endif
+            printf(" -> %.*G, reference %.21LG", digits, worst[i].r, worst[i].e);
+        }
+#ifdef HEATMAP
+        printHeatMap();
+#endif
+    }
+#ifdef HEATMAP
+    // unbiased exponent of bucket. Zero and subnormal give -bias, INF and NAN give bias+1
+    static int bucketExponent(int i) {
+        return (i & (numExponents - 1)) - (numExponents / 2 - 1);
+    }
+    // print max and mean error for each sign and exponent of first input
+    void printHeatMap() const {
+        printf("\nError by sign and exponent of x. '#' = log2 of max error:");
+        printf("\nsign exponent        count     max ULP    mean ULP");
+        for (int s = 0; s < 2; s++) {
+            for (int j = 0; j < numExponents; j++) {
+                int i = s * numExponents + j;
+                if (bucketCount[i] == 0) continue;
+                int e = bucketExponent(i);
+                char ename[16];
+                if (j == 0) strcpy(ename, "sub");
+                else if (j == numExponents - 1) strcpy(ename, "inf/nan");
+                else snprintf(ename, sizeof(ename), "%i", e);
+                double mean = bucketValid[i] ? bucketSum[i] / double(bucketValid[i]) : 0.;
+                printf("\n   %c %8s %12llu %11.4G %11.4G  ", s ? '-' : '+', ename, 
+                    (unsigned long long)bucketCount[i], bucketMax[i], mean);
+                int bar = bucketMax[i] > 0. ? binIndex(bucketMax[i]) : 0;
+                for (int k = 0; k < bar; k++) printf("#");
+            }
+        }
+    }
+#endif
+    // append statistics to file
+    void writeFile(const char * filename) const {
+        FILE * ff = fopen(filename, "a");
+        if (ff == 0) {
+            printf("\nCannot write file %s", filename);
+            return;
+        }
+        fprintf(ff, "hist,%i,%s,%i,%llu,%.6G,%.6G", testcase, TOSTRING(vtype), INSTRSET, 
+            (unsigned long long)count, maxdif, mean());
+        for (int i = 0; i < numBins; i++) fprintf(ff, ",%llu", (unsigned long long)bins[i]);
+        fprintf(ff, "\n");
+        for (int i = 0; i < numworst; i++) {
+            fprintf(ff, "worst,%i,%s,%i,%i,%.6G,%.17G,%.17G,%.17G,%.21LG\n", testcase, TOSTRING(vtype), INSTRSET, 
+                i + 1, worst[i].dif, worst[i].a, worst[i].b, worst[i].r, worst[i].e);
+        }
+#ifdef HEATMAP
+        for (int i = 0; i < numBuckets; i++) {
+            if (bucketCount[i] == 0) continue;
+            fprintf(ff, "bucket,%i,%s,%i,%c,%i,%llu,%.6G,%.6G\n", testcase, TOSTRING(vtype), INSTRSET, 
+                i >= numExponents ? '-' : '+', bucketExponent(i), (unsigned long long)bucketCount[i], bucketMax[i], 
+                bucketValid[i] ? bucketSum[i] / double(bucketValid[i]) : 0.);
+        }
+#endif
+        fclose(ff);
+    }
+};
+
+
+#if defined(REFERENCE_CACHE) && (testcase < 100 || defined(TWO_PARAMETERS) || defined(EXHAUSTIVE_TEST))
+#undef REFERENCE_CACHE            // cache is only for one-parameter mathematical functions
+#endif
+
+#ifdef REFERENCE_CACHE
+// ----------------------------------------------------------------------------
+//         Cache of reference values, shared between vector types and instruction sets
+// ----------------------------------------------------------------------------
+#ifndef CACHEDIR
+#define CACHEDIR "."              // directory for cache files
+#endif
+#define CACHE_VERSION   2         // file format version
+#define DATAGEN_VERSION 2         // increment when TestData or the reference functions are changed
+#ifdef DD_REFERENCE
+#define REFERENCE_MODE  1         // reference values calculated with double-double arithmetic
+#else
+#define REFERENCE_MODE  0         // reference values calculated with long double
+#endif
+
+// Cache file header. The header is followed by count inputs of type ST, 
+// padded to a multiple of 16 bytes, and count reference values of type long double
+struct RefCacheHeader {
+    char magic[8];                // "VCLREF3"
+    uint32_t version;             // CACHE_VERSION
+    int32_t  testCase;            // testcase
+    int32_t  randomSeed;          // seed
+    uint32_t inputSize;           // sizeof(ST)
+    uint32_t resultSize;          // sizeof(long double)
+    uint32_t count;               // number of inputs
+    uint32_t fma;                 // 1 if INSTRSET >= 8. Trig input limits depend on FMA
+    uint32_t datagenVersion;      // DATAGEN_VERSION
+    uint32_t referenceMode;       // REFERENCE_MODE. 1 = double-double, 0 = long double
+    uint32_t reserved;            // 0. Alignment of checksum
+    uint64_t checksum;            // FNV-1a hash of inputs and results
+};
+
+// FNV-1a hash
+uint64_t fnv1a(const void * data, size_t size, uint64_t hash = 0xCBF29CE484222325) {
+    const uint8_t * p = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
+
+class ReferenceCache {
+public:
+    ReferenceCache() {
+        mapped = 0;  buffer = 0;  fileSize = 0;
+    }
+    ~ReferenceCache() {
+        unmap();
+        delete[] buffer;
+    }
+    // get reference values for a list of inputs. 
+    // The cache file is loaded, or generated if it does not exist or is invalid
+    const long double * get(const ST * inputs, uint32_t count) {
+        char filename[256];
+        snprintf(filename, sizeof(filename), "%s/ref3_%i_%s_%i%s%s.bin", CACHEDIR, testcase, 
+            sizeof(ST) > 4 ? "d" : "f", seed, INSTRSET >= 8 ? "_fma" : "", REFERENCE_MODE ? "_dd" : "_ld");
+        makeHeader(count);
+        if (map(filename)) {
+            const long double * results = validate((const char *)mapped, fileSize, inputs);
+            if (results) {
+                printf("\nReference values loaded from %s", filename);
+                return results;
+            }
+            unmap();
+            printf("\nReference cache %s is invalid", filename);
+        }
+        return generate(filename, inputs);
+    }
+protected:
+    RefCacheHeader header;        // expected header, without checksum
+    void * mapped;                // memory-mapped file
+    size_t fileSize;              // size of mapped file
+    char * buffer;                // generated data
+    // offset of results in file
+    size_t resultOffset() const {
+        return (sizeof(RefCacheHeader) + header.count * sizeof(ST) + 15) & ~size_t(15);
+    }
+    size_t totalSize() const {
+        return resultOffset() + header.count * sizeof(long double);
+    }
+    void makeHeader(uint32_t count) {
+        memset(&header, 0, sizeof(header));
+        strcpy(header.magic, "VCLREF3");
+        header.version = CACHE_VERSION;
+        header.testCase = testcase;
+        header.randomSeed = seed;
+        header.inputSize = sizeof(ST);
+        header.resultSize = sizeof(long double);
+        header.count = count;
+        header.fma = INSTRSET >= 8;
+        header.datagenVersion = DATAGEN_VERSION;
+        header.referenceMode = REFERENCE_MODE;
+    }
+    // check header, inputs, and checksum of file data. Returns pointer to results, or 0 if invalid
+    const long double * validate(const char * data, size_t size, const ST * inputs) {
+        RefCacheHeader h;
+        if (size != totalSize()) return 0;
+        memcpy(&h, data, sizeof(h));
+        uint64_t checksum = h.checksum;
+        h.checksum = 0;
+        if (memcmp(&h, &header, sizeof(h)) != 0) return 0;
+        const char * inputdata = data + sizeof(RefCacheHeader);
+        if (memcmp(inputdata, inputs, header.count * sizeof(ST)) != 0) return 0;
+        if (fnv1a(inputdata, size - sizeof(RefCacheHeader)) != checksum) return 0;
+        return (const long double *)(data + resultOffset());
+    }
+    // calculate reference values in all threads and write cache file
+    const long double * generate(const char * filename, const ST * inputs) {
+        size_t size = totalSize();
+        buffer = new char[size];
+        memset(buffer, 0, size);
+        char * inputdata = buffer + sizeof(RefCacheHeader);
+        long double * results = (long double *)(buffer + resultOffset());
+        memcpy(inputdata, inputs, header.count * sizeof(ST));
+        int nthreads = std::thread::hardware_concurrency();
+        if (nthreads <= 0) nthreads = 1;
+        std::thread * threads = new std::thread[nthreads];
+        uint32_t n = header.count;
+        for (int t = 0; t < nthreads; t++) {
+            threads[t] = std::thread([=]() {
+                for (uint32_t i = n * t / nthreads; i < n * (t + 1ull) / nthreads; i++) {
+                    results[i] = referenceFunction(inputs[i]);
+                }
+            });
+        }
+        for (int t = 0; t < nthreads; t++) threads[t].join();
+        delete[] threads;
+        header.checksum = fnv1a(inputdata, size - sizeof(RefCacheHeader));
+        memcpy(buffer, &header, sizeof(header));
+        // write to temporary file first, in case other processes are reading the same file
+        char tempname[260];
+        snprintf(tempname, sizeof(tempname), "%s.tmp", filename);
+        FILE * ff = fopen(tempname, "wb");
+        if (ff == 0 || fwrite(buffer, 1, size, ff) != size) {
+            printf("\nCannot write reference cache %s", tempname);
+            if (ff) fclose(ff);
+            return results;
+        }
+        fclose(ff);
+        remove(filename);
+        if (rename(tempname, filename) != 0) remove(tempname);
+        else printf("\nReference values written to %s", filename);
+        return results;
+    }
+#ifdef _WIN32
+    bool map(const char * filename) {
+        HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if (hFile == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        HANDLE hMap = 0;
+        if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0) {
+            hMap = CreateFileMappingA(hFile, 0, PAGE_READONLY, 0, 0, 0);
+        }
+        if (hMap) {
+            mapped = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(hMap);    // the view keeps the mapping open
+        }
+        CloseHandle(hFile);
+        fileSize = mapped ? size_t(size.QuadPart) : 0;
+        return mapped != 0;
+    }
+    void unmap() {
+        if (mapped) UnmapViewOfFile(mapped);
+        mapped = 0;
+    }
+#else
+    bool map(const char * filename) {
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void * p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                mapped = p;
+                fileSize = st.st_size;
+            }
+        }
+        close(fd);                // the mapping remains valid
+        return mapped != 0;
+    }
+    void unmap() {
+        if (mapped) munmap(mapped, fileSize);
+        mapped = 0;
+    }
+#endif
+};
+#endif  // REFERENCE_CACHE
+
+
+#ifdef BENCHMARK
+// ----------------------------------------------------------------------------
+//         Benchmark of test function versus scalar standard library function
+// ----------------------------------------------------------------------------
+#if testcase < 100 || !defined(SCALARFUNC)
+#error BENCHMARK is only for mathematical functions with a scalar function for comparison
+#endif
+#ifndef BENCHFILE
+#define BENCHFILE "bench3.csv"    // file for benchmark results
+#endif
+#ifndef BENCHREPEAT
+#define BENCHREPEAT 20            // number of repetitions. The fastest is used
+#endif
+#ifdef USEMATHLIB
+#define LIBRARYNAME "mathlib"     // vectormath_lib.h, using SVML
+#else
+#define LIBRARYNAME "vcl"         // VCL vectormath functions
+#endif
+#if defined(TRIG_HARD_CASES)
+#define DATANAME "hardtrig"       // hard cases for trigonometric functions
+#elif defined(BUCKET_SAMPLES)
+#define DATANAME "buckets"        // samples for each exponent
+#else
+#define DATANAME "default"        // default test data
+#endif
+#ifdef EMULATED
+const int emulated = 1;           // running in emulator. Clock counts are not valid
+#else
+const int emulated = 0;
+#endif
+
+// read time stamp counter
+static inline uint64_t readTSC() {
+    return __rdtsc();
+}
+
+// result arrays. The size of the test data is a multiple of the vector size
+RT benchVector[TestData<ST>::maxsize];     // results of vector benchmark
+ST benchScalar[TestData<ST>::maxsize];     // results of scalar benchmark
+volatile double benchSink;        // prevent optimizing away the results
+
+// measure clock cycles per element for test function and scalar function
+// over the same test data. Print results and append them to BENCHFILE
+void benchmark(const ST * alist, int asize, const ST * blist, int bsize, ErrorStatistics const & stat) {
+    const int vectorsize = sizeof(vtype) / sizeof(ST);
+    vtype a, b;
+    uint64_t vectorTime = ~uint64_t(0), scalarTime = ~uint64_t(0);
+    int i, r;
+    uint64_t numElements = 0;
+    for (r = 0; r < BENCHREPEAT; r++) {
+        uint64_t time0 = readTSC();
+#ifdef TWO_PARAMETERS
+        // same combinations of parameters as in the test
+        for (i = 0; i < asize; i += vectorsize) {
+            a.load(alist + i);
+            for (int j = 0; j < bsize; j += vectorsize) {
+                b.load(blist + j);
+                testFunction(a, b).store(benchVector + j);
+            }
+        }
+        uint64_t time1 = readTSC();
+        for (i = 0; i < asize; i += vectorsize) {
+            for (int j = 0; j < bsize; j += vectorsize) {
+                for (int k = 0; k < vectorsize; k++) {
+                    benchScalar[j + k] = SCALARFUNC(alist[i + k], blist[j + k]);
+                }
+            }
+        }
+        numElements = uint64_t(asize / vectorsize) * bsize;
+#else
+        for (i = 0; i < asize; i += vectorsize) {
+            a.load(alist + i);
+            testFunction(a).store(benchVector + i);
+        }
+        uint64_t time1 = readTSC();
+        for (i = 0; i < asize; i++) {
+            benchScalar[i] = SCALARFUNC(alist[i]);
+        }
+        numElements = asize;
+#endif
+        uint64_t time2 = readTSC();
+        if (time1 - time0 < vectorTime) vectorTime = time1 - time0;
+        if (time2 - time1 < scalarTime) scalarTime = time2 - time1;
+        benchSink = double(benchVector[r % vectorsize]) + double(benchScalar[r % vectorsize]);
+    }
+    double vectorClocks = double(vectorTime) / double(numElements);
+    double scalarClocks = double(scalarTime) / double(numElements);
+    printf("\nBenchmark of test case %i, %s, instruction set %i, %s, %s data:", 
+        testcase, TOSTRING(vtype), INSTRSET, LIBRARYNAME, DATANAME);
+    printf("\n  vector function: %8.2f clock cycles per element", vectorClocks);
+    printf("\n  scalar loop:     %8.2f clock cycles per element", scalarClocks);
+    printf("\n  speedup %.2f, max error %.3G ULP, mean error %.3G ULP", 
+        scalarClocks / vectorClocks, stat.maxdif, stat.mean());
+    if (emulated) printf("\n  running in emulator. Clock counts are not valid");
+    FILE * ff = fopen(BENCHFILE, "a");
+    if (ff == 0) {
+        printf("\nCannot write file %s", BENCHFILE);
+        return;
+    }
+    fseek(ff, 0, SEEK_END);
+    if (ftell(ff) == 0) {                        // new file. Write header
+        fprintf(ff, "testcase,vtype,INSTRSET,fma,library,data,vector_clocks,scalar_clocks,speedup,max_ulp,mean_ulp,emulated\n");
+    }
+    fprintf(ff, "%i,%s,%i,%i,%s,%s,%.3f,%.3f,%.3f,%.4G,%.4G,%i\n", testcase, TOSTRING(vtype), INSTRSET, 
+        INSTRSET >= 8, LIBRARYNAME, DATANAME, vectorClocks, scalarClocks, scalarClocks / vectorClocks, 
+        stat.maxdif, stat.mean(), emulated);
+    fclose(ff);
 }
+#endif  // BENCHMARK
 
 
+#ifdef EXHAUSTIVE_TEST
+// ----------------------------------------------------------------------------
+//         Exhaustive test of all float inputs, distributed between threads
+// ----------------------------------------------------------------------------
+#ifdef TWO_PARAMETERS
+#error EXHAUSTIVE_TEST is only for functions with one parameter
+#endif
+static_assert(sizeof(ST) == 4 && ST(0.5) != 0, "EXHAUSTIVE_TEST requires float input");
+
+#ifndef EXPONENT_MIN
+#define EXPONENT_MIN  -127   // unbiased exponent. -127 means zero and subnormal
+#endif
+#ifndef EXPONENT_MAX
+#define EXPONENT_MAX   128   // unbiased exponent. 128 means INF and NAN
+#endif
+
+// number of inputs of each sign
+const uint64_t exponentSpan = uint64_t(EXPONENT_MAX - EXPONENT_MIN + 1) << 23;
+const uint64_t numInputs = exponentSpan * 2;     // total number of inputs
+const uint64_t chunkSize = 0x10000;              // number of inputs in each chunk of work
+std::atomic<uint64_t> nextChunk(0);              // next chunk to test
+
+// get bit pattern of input number n
+inline uint32_t sweepInput(uint64_t n) {
+    uint32_t sign = uint32_t(n / exponentSpan);
+    return (sign << 31) + (uint32_t(EXPONENT_MIN + 127) << 23) + uint32_t(n % exponentSpan);
+}
+
+// results from one thread
+struct SweepResult {
+    uint64_t numerrors = 0;                      // number of errors bigger than FACCURACY
+    ErrorStatistics stat;                        // histogram and worst results
+};
+
+// test chunks of inputs until all inputs are done
+void sweepThread(SweepResult * res) {
+    vtype a;                                     // input vector
+    rtype result;                                // result vector
+    const int vectorsize = sizeof(vtype) / sizeof(ST);
+    uint32_t bits[vectorsize];                   // input bit patterns
+    ST list[vectorsize];                         // input values
+    int k;
+    while (true) {
+        uint64_t chunk = nextChunk++;            // get next chunk of work
+        uint64_t first = chunk * chunkSize;
+        if (first >= numInputs) break;           // finished
+        for (uint64_t n = first; n < first + chunkSize; n += vectorsize) {
+            for (k = 0; k < vectorsize; k++) bits[k] = sweepInput(n + k);
+            memcpy(list, bits, sizeof(list));
+            a.load(list);
+            result = testFunction(a);            // function under test
+            for (k = 0; k < vectorsize; k++) {
+                ST x = list[k];
+                if (std::fabs(x) > (ST)MAXF && (bits[k] & 0x7FFFFFFF) < 0x7F800000) continue; // skip too big
+                long double expected = referenceFunction(x);
+                double dif = compare_scalars(result[k], expected);
+                bool ignore = false;
+                if (dif > FACCURACY || dif == -1. || dif != dif) {
+                    ignore = ignoreError(x, result[k], expected);
+                    if (!ignore) {
+                        res->numerrors++;
+                        std::lock_guard<std::mutex> lock(printMutex);
+                        if (numerr < maxerrors) {
+                            errorreport(int(chunk), int(n - first) + k, x, result[k], expected);
+                            numerr++;
+                        }
+                    }
+                }
+                if (result[k] == expected) dif = 0;
+                res->stat.add(dif, ignore, x, 0., result[k], expected);
+            }
+        }
+    }
+}
+
+// run exhaustive test in all threads and report results. Returns number of errors
+uint64_t exhaustiveTest(int nthreads, ErrorStatistics & stat) {
+    if (nthreads <= 0) nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0) nthreads = 1;
+    SweepResult * results = new SweepResult[nthreads];
+    std::thread * threads = new std::thread[nthreads];
+    auto time0 = std::chrono::steady_clock::now();
+    uint64_t numerrors = 0;
+    int t;
+    for (t = 0; t < nthreads; t++) {
+        threads[t] = std::thread(sweepThread, results + t);
+    }
+    for (t = 0; t < nthreads; t++) {             // combine results
+        threads[t].join();
+        numerrors += results[t].numerrors;
+        stat.merge(results[t].stat);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time0).count();
+    printf("\nExhaustive test of test case %i, exponent %i to %i: %llu inputs tested in %.1f seconds, %i threads",
+        testcase, EXPONENT_MIN, EXPONENT_MAX, (unsigned long long)stat.count, seconds, nthreads);
+    printf("\n%llu errors > %G ULP, %llu errors ignored", 
+        (unsigned long long)numerrors, double(FACCURACY), (unsigned long long)stat.bins[ErrorStatistics::binIgnored]);
+    if (stat.numworst > 0) {
+        float maxinput = (float)stat.worst[0].a;
+        uint32_t maxbits;
+        memcpy(&maxbits, &maxinput, sizeof(maxbits));
+        printf("\nMax error %.6G ULP at x = %.9G (0x%08X): result %.9G, reference %.12LG",
+            stat.worst[0].dif, maxinput, maxbits, stat.worst[0].r, stat.worst[0].e);
+    }
+    delete[] threads;
+    delete[] results;
+    return numerrors;
+}
+#endif  // EXHAUSTIVE_TEST
+
+
+#ifdef GRID_TEST
+// ----------------------------------------------------------------------------
+//         Grid test of functions with two parameters, distributed between threads
+// ----------------------------------------------------------------------------
+#ifndef TWO_PARAMETERS
+#error GRID_TEST is only for functions with two parameters
+#endif
+#ifndef GRID_SIZE
+#define GRID_SIZE 4096       // number of grid points in each dimension of each region
+#endif
+#ifndef GRID_REGIONS
+#define GRID_REGIONS 0xF     // bit mask of regions to test
+#endif
+static_assert(GRID_SIZE % 16 == 0, "GRID_SIZE must be a multiple of the vector size");
+
+#ifdef YACCURACY
+const double yAccuracy = YACCURACY;              // accuracy relative to second parameter
+#else
+const double yAccuracy = 0;
+#endif
+
+// regions of the grid test
+enum GridRegion {
+    regionLogGrid,           // x and y log-uniform over the whole range, both signs
+    regionNearOne,           // x near 1, big |y|
+    regionOverflow,          // x^y near the overflow limit
+    regionUnderflow,         // x^y near the underflow limit, including subnormal results
+    numRegions
+};
+const char * regionNames[numRegions] = {"log grid", "x near 1", "overflow", "underflow"};
+
+std::atomic<uint64_t> nextRow(0);                // next row of grid to test
+
+// make grid point (x, y) in a region from grid coordinates u, v in (0,1)
+void gridPoint(int region, double u, double v, ST & x, ST & y) {
+    const double m = sizeof(ST) > 4 ? (double)MAXD : (double)MAXF; // max parameter
+    const double hi = std::log2(m);              // max exponent of parameter
+    const double lo = sizeof(ST) > 4 ? -1022. : -126.;  // min exponent of normal numbers
+    const double emax = sizeof(ST) > 4 ? 1024. : 128.;  // exponent of result that overflows
+    const double mantissaBits = sizeof(ST) > 4 ? 53. : 24.;
+    double su = u < 0.5 ? 1. : -1.;              // sign from u
+    double sv = v < 0.5 ? 1. : -1.;              // sign from v
+    double u2 = u < 0.5 ? 2. * u : 2. * u - 1.;  // u without sign
+    double v2 = v < 0.5 ? 2. * v : 2. * v - 1.;  // v without sign
+    double xx = 0, yy = 0, lx, target;
+    switch (region) {
+    case regionLogGrid:
+        xx = su * std::exp2(lo + (hi - lo) * u2);
+        yy = sv * std::exp2(lo + (hi - lo) * v2);
+        break;
+    case regionNearOne:
+        xx = 1. + su * std::exp2(-mantissaBits * u2);  // 1 +/- 2^-k
+        yy = sv * std::exp2(hi * v2);                  // |y| from 1 to max
+        break;
+    case regionOverflow: case regionUnderflow:
+        // log2(x) uniform, y makes y*log2(x) close to the limit
+        lx = (2. * u - 1.) * (hi < -lo ? hi : -lo);
+        if (std::fabs(lx) < 1./1024.) lx = lx < 0 ? -1./1024. : 1./1024.;
+        if (region == regionOverflow) target = emax - 2. + 4. * v;
+        else target = lo - mantissaBits - 1. + (mantissaBits + 3.) * v;
+        xx = std::exp2(lx);
+        yy = target / lx;
+        break;
+    }
+    if (std::fabs(xx) > m) xx = xx < 0 ? -m : m;
+    if (std::fabs(yy) > m) yy = yy < 0 ? -m : m;
+    x = (ST)xx;  y = (ST)yy;
+}
+
+// results from one thread
+struct GridResult {
+    uint64_t numerrors[numRegions] = {0};        // number of errors bigger than the limit
+    ErrorStatistics stat[numRegions];            // statistics for each region
+};
+
+// test rows of grids until all rows are done
+void gridThread(GridResult * res) {
+    vtype a, b;                                  // input vectors
+    rtype result;                                // result vector
+    const int vectorsize = sizeof(vtype) / sizeof(ST);
+    ST xlist[vectorsize], ylist[vectorsize];     // input values
+    int k;
+    while (true) {
+        uint64_t row = nextRow++;                // get next row of work
+        int region = int(row / GRID_SIZE);
+        if (region >= numRegions) break;         // finished
+        if (!(GRID_REGIONS >> region & 1)) continue;  // region not selected
+        double v = (double(row % GRID_SIZE) + 0.5) / GRID_SIZE;
+        for (int col = 0; col < GRID_SIZE; col += vectorsize) {
+            for (k = 0; k < vectorsize; k++) {
+                gridPoint(region, (double(col + k) + 0.5) / GRID_SIZE, v, xlist[k], ylist[k]);
+            }
+            a.load(xlist);  b.load(ylist);
+            result = testFunction(a, b);         // function under test. May modify b
+            for (k = 0; k < vectorsize; k++) {
+                long double expected = referenceFunction(a[k], b[k]);
+                double dif = compare_scalars(result[k], expected);
+                double limit = FACCURACY + yAccuracy * std::fabs(b[k]);
+                bool ignore = false;
+                if (dif > limit || dif == -1. || dif != dif) {
+                    ignore = ignoreError(a[k], b[k], result[k], expected);
+                    if (!ignore) {
+                        res->numerrors[region]++;
+                        std::lock_guard<std::mutex> lock(printMutex);
+                        if (numerr < maxerrors) {
+                            errorreport(int(row), col, k, a[k], b[k], result[k], expected);
+                            numerr++;
+                        }
+                    }
+                }
+                if (result[k] == expected) dif = 0;
+                res->stat[region].add(dif, ignore, a[k], b[k], result[k], expected);
+            }
+        }
+    }
+}
+
+// run grid test in all threads and report results for each region. Returns number of errors
+uint64_t gridTest(int nthreads, ErrorStatistics & stat) {
+    if (nthreads <= 0) nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0) nthreads = 1;
+    GridResult * results = new GridResult[nthreads];
+    std::thread * threads = new std::thread[nthreads];
+    ErrorStatistics regionStat[numRegions];
+    uint64_t regionErrors[numRegions] = {0};
+    auto time0 = std::chrono::steady_clock::now();
+    uint64_t numerrors = 0;
+    int t, r;
+    for (t = 0; t < nthreads; t++) {
+        threads[t] = std::thread(gridThread, results + t);
+    }
+    for (t = 0; t < nthreads; t++) {             // combine results
+        threads[t].join();
+        for (r = 0; r < numRegions; r++) {
+            regionStat[r].merge(results[t].stat[r]);
+            regionErrors[r] += results[t].numerrors[r];
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time0).count();
+    printf("\nGrid test of test case %i, %i x %i points per region, %.1f seconds, %i threads",
+        testcase, GRID_SIZE, GRID_SIZE, seconds, nthreads);
+    printf("\nregion              pairs     max ULP    mean ULP   limit at max      errors  worst x, y");
+    FILE * ff = fopen(STATFILE, "a");
+    for (r = 0; r < numRegions; r++) {
+        ErrorStatistics const & s = regionStat[r];
+        if (s.count == 0) continue;
+        // accuracy limit scaled by YACCURACY at the worst input
+        double limit = FACCURACY + (s.numworst ? yAccuracy * std::fabs(s.worst[0].b) : 0.);
+        printf("\n%-10s %14llu %11.4G %11.4G %14.4G %11llu", regionNames[r], (unsigned long long)s.count, 
+            s.maxdif, s.mean(), limit, (unsigned long long)regionErrors[r]);
+        if (s.numworst) printf("  %.9G, %.9G", s.worst[0].a, s.worst[0].b);
+        if (ff) {
+            fprintf(ff, "region,%i,%s,%i,%s,%llu,%.6G,%.6G,%.6G,%llu\n", testcase, TOSTRING(vtype), INSTRSET, 
+                regionNames[r], (unsigned long long)s.count, s.maxdif, s.mean(), limit, 
+                (unsigned long long)regionErrors[r]);
+        }
+        stat.merge(s);
+        numerrors += regionErrors[r];
+    }
+    if (ff) fclose(ff);
+    delete[] threads;
+    delete[] results;
+    return numerrors;
+}
+#endif  // GRID_TEST
+
+
+#ifdef DENORMAL_TEST
+// ----------------------------------------------------------------------------
+//         Test with flush-to-zero and denormals-are-zero modes
+// ----------------------------------------------------------------------------
+#if defined(EXHAUSTIVE_TEST) || defined(GRID_TEST) || defined(BENCHMARK)
+#error DENORMAL_TEST cannot be combined with EXHAUSTIVE_TEST, GRID_TEST or BENCHMARK
+#endif
+#ifndef DENORMAL_SAMPLES
+#define DENORMAL_SAMPLES 4096     // number of inputs in each data set
+#endif
+#ifndef DENORMAL_SEARCH
+#define DENORMAL_SEARCH 0x1000000 // max number of random inputs searched for subnormal results
+#endif
+#ifndef BENCHREPEAT
+#define BENCHREPEAT 20            // number of repetitions of timing. The fastest is used
+#endif
+
+// read time stamp counter
+static inline uint64_t readTSC() {
+    return __rdtsc();
+}
+
+// MXCSR bits
+const uint32_t mxcsrFTZ = 0x8000;                // flush to zero: subnormal results are set to zero
+const uint32_t mxcsrDAZ = 0x0040;                // denormals are zero: subnormal inputs are treated as zero
+const int numDenormalModes = 4;
+const uint32_t denormalModeBits[numDenormalModes] = {0, mxcsrFTZ, mxcsrDAZ, mxcsrFTZ | mxcsrDAZ};
+const char * denormalModeNames[numDenormalModes] = {"default", "FTZ", "DAZ", "FTZ+DAZ"};
+
+// data set with results for each mode
+struct DenormalSet {
+    enum {size = (DENORMAL_SAMPLES + 15) & -16}; // rounded up to a multiple of the vector size
+    const char * name;                           // name of data set
+    int num;                                     // number of inputs
+    ST a[size], b[size];                         // inputs. b is used only with two parameters
+    long double e[size];                         // reference values, calculated in default mode
+    RT r[numDenormalModes][size];                // results for each mode
+    ErrorStatistics stat[numDenormalModes];      // accuracy for each mode
+    uint64_t changed[numDenormalModes];          // number of results different from default mode
+    double clocks[numDenormalModes];             // clock cycles per element
+};
+
+// check if x is a subnormal number of type T
+template <typename T>
+bool isSubnormal(long double x) {
+    const double minNormal = sizeof(T) > 4 ? DBL_MIN : FLT_MIN;
+    return x != 0 && std::fabs(x) < minNormal;
+}
+
+// random input for search. Half of the inputs are log-uniform over the whole range including 
+// subnormal numbers, and half are uniform. The range goes to twice the max parameter 
+// to find inputs that underflow
+ST denormalRandomInput() {
+    const double maxtype = sizeof(ST) > 4 ? DBL_MAX : FLT_MAX;
+    double m = 2. * (sizeof(ST) > 4 ? (double)MAXD : (double)MAXF); // max input
+    if (m > maxtype) m = maxtype;
+    const double emin = sizeof(ST) > 4 ? -1074. : -149.;  // exponent of smallest subnormal
+    double x;
+    if (ran.next() & 2) {
+        x = std::exp2(emin + (std::log2(m) - emin) * get_random<double>(ran));
+    }
+    else {
+        x = m * get_random<double>(ran);
+    }
+    if (x > m) x = m;
+    return ST((ran.next() & 1) ? -x : x);
+}
+
+// calculate the test function and reference in default mode. 
+// The second parameter may be modified by testFunction
+void denormalReference(DenormalSet & d) {
+    const int vectorsize = sizeof(vtype) / sizeof(ST);
+    vtype a, b;
+    rtype y;
+    for (int i = 0; i < d.num; i += vectorsize) {
+        a.load(d.a + i);
+#ifdef TWO_PARAMETERS
+        b.load(d.b + i);
+        y = testFunction(a, b);
+        b.store(d.b + i);
+        for (int k = 0; k < vectorsize; k++) d.e[i + k] = referenceFunction(a[k], b[k]);
+#else
+        y = testFunction(a);
+        for (int k = 0; k < vectorsize; k++) d.e[i + k] = referenceFunction(a[k]);
+#endif
+    }
+}
+
+// make data set of inputs that are subnormal or give subnormal results in the default mode.
+// A quarter of the inputs have subnormal parameters if there are enough inputs with subnormal results
+void makeDenormalSet(DenormalSet & d) {
+    const int vectorsize = sizeof(vtype) / sizeof(ST);
+    const int maxInputs = DenormalSet::size / 4; // inputs with subnormal parameter, but normal result
+    ST extraA[DenormalSet::size], extraB[DenormalSet::size];  // extra subnormal inputs
+    int numExtra = 0;
+    ST alist[vectorsize], blist[vectorsize];
+    vtype a, b;
+    rtype y;
+    d.num = 0;
+    for (int n = 0; n < DENORMAL_SEARCH && d.num < DenormalSet::size - maxInputs; n += vectorsize) {
+        for (int k = 0; k < vectorsize; k++) {
+            alist[k] = denormalRandomInput();
+            blist[k] = denormalRandomInput();
+        }
+        a.load(alist);  b.load(blist);
+#ifdef TWO_PARAMETERS
+        y = testFunction(a, b);                  // may modify b, used in referenceFunction
+#else
+        y = testFunction(a);                     // may set variables used in referenceFunction
+#endif
+        for (int k = 0; k < vectorsize; k++) {
+#ifdef TWO_PARAMETERS
+            long double e = referenceFunction(a[k], b[k]);
+            bool subnormalInput = isSubnormal<ST>(a[k]) || isSubnormal<ST>(b[k]);
+#else
+            long double e = referenceFunction(a[k]);
+            bool subnormalInput = isSubnormal<ST>(a[k]);
+#endif
+            if (isSubnormal<RT>(e) && RT(0.5) != 0) {  // subnormal result
+                d.a[d.num] = a[k];  d.b[d.num] = b[k];  d.num++;
+            }
+            else if (subnormalInput && numExtra < DenormalSet::size) {
+                extraA[numExtra] = a[k];  extraB[numExtra] = b[k];  numExtra++;
+            }
+        }
+    }
+    int numResults = d.num;
+    // fill the rest with subnormal inputs
+    for (int j = 0; j < numExtra && d.num < DenormalSet::size; j++) {
+        d.a[d.num] = extraA[j];  d.b[d.num] = extraB[j];  d.num++;
+    }
+    // fill last vector with copies of the first inputs
+    for (int j = 0; d.num == 0 || d.num % vectorsize != 0; j++) {
+        d.a[d.num] = d.num ? d.a[j] : ST(0);  d.b[d.num] = d.num ? d.b[j] : ST(0);  d.num++;
+    }
+    printf("\nSubnormal data: %i inputs giving subnormal results, %i subnormal inputs", 
+        numResults, d.num - numResults);
+}
+
+// run test function on all inputs of data set. Results are stored in r
+void denormalRun(DenormalSet & d, RT * r) {
+    const int vectorsize = sizeof(vtype) / sizeof(ST);
+    vtype a, b;
+    rtype y;
+    for (int i = 0; i < d.num; i += vectorsize) {
+        a.load(d.a + i);
+#ifdef TWO_PARAMETERS
+        b.load(d.b + i);
+        y = testFunction(a, b);
+#else
+        y = testFunction(a);
+#endif
+        for (int k = 0; k < vectorsize; k++) r[i + k] = y[k];
+    }
+}
+
+// run data set in all modes and compare results. Returns number of errors in default mode
+uint64_t denormalCompare(DenormalSet & d) {
+    static RT benchResult[DenormalSet::size];
+    uint32_t controlWord = get_control_word();   // save MXCSR
+    uint64_t numerrors = 0;
+    for (int m = 0; m < numDenormalModes; m++) {
+        set_control_word((controlWord & ~(mxcsrFTZ | mxcsrDAZ)) | denormalModeBits[m]);
+        denormalRun(d, d.r[m]);
+        uint64_t bestTime = ~uint64_t(0);
+        for (int rep = 0; rep < BENCHREPEAT; rep++) {
+            uint64_t time0 = readTSC();
+            denormalRun(d, benchResult);
+            uint64_t time1 = readTSC();
+            if (time1 - time0 < bestTime) bestTime = time1 - time0;
+        }
+        set_control_word(controlWord);           // compare in default mode
+        d.clocks[m] = double(bestTime) / d.num;
+        d.changed[m] = 0;
+        for (int i = 0; i < d.num; i++) {
+            RT r = d.r[m][i];
+            long double e = d.e[i];
+            x0 = d.a[i];                         // used with IGNORE_UNDERFLOW
+            if (memcmp(&r, &d.r[0][i], sizeof(RT)) != 0) d.changed[m]++;
+            double dif = compare_scalars(r, e);
+#ifdef YACCURACY
+            double limit = FACCURACY + YACCURACY * std::fabs(d.b[i]);
+#else
+            double limit = FACCURACY;
+#endif
+            bool ignore = false;
+            if (dif > limit || dif == -1. || dif != dif) {
+#ifdef TWO_PARAMETERS
+                ignore = ignoreError(d.a[i], d.b[i], r, e);
+#else
+                ignore = ignoreError(d.a[i], r, e);
+#endif
+                if (m == 0 && !ignore) {
+                    numerrors++;
+                    if (numerr < maxerrors) {
+#ifdef TWO_PARAMETERS
+                        errorreport(i, 0, 0, d.a[i], d.b[i], r, e);
+#else
+                        errorreport(i, 0, d.a[i], r, e);
+#endif
+                        numerr++;
+                    }
+                }
+            }
+            if (r == e) dif = 0;
+            d.stat[m].add(dif, ignore, d.a[i], d.b[i], r, e);
+        }
+    }
+    return numerrors;
+}
+
+// test function with default data and subnormal data in all combinations of FTZ and DAZ.
+// Returns number of errors in default mode
+uint64_t denormalTest(TestData<ST> & adata, ErrorStatistics & stat) {
+    static DenormalSet sets[2];
+    DenormalSet & normal = sets[0];              // default test data
+    DenormalSet & subnormal = sets[1];           // subnormal inputs or results
+    int i, m, s;
+    normal.name = "default";  subnormal.name = "subnormal";
+    // default test data
+    normal.num = adata.size() < DenormalSet::size ? adata.size() : DenormalSet::size;
+#ifdef TWO_PARAMETERS
+    static TestData<ST> bdata;                   // test data for second parameter
+    normal.num = DenormalSet::size;              // combinations of first and second parameter
+    for (i = 0; i < normal.num; i++) {
+        normal.a[i] = adata.list[i % adata.size()];
+        normal.b[i] = bdata.list[(i / adata.size() + i * 7) % bdata.size()];
+    }
+#else
+    for (i = 0; i < normal.num; i++) {
+        normal.a[i] = adata.list[i];  normal.b[i] = 0;
+    }
+#endif
+    makeDenormalSet(subnormal);
+    uint64_t numerrors = 0;
+    for (s = 0; s < 2; s++) {
+        denormalReference(sets[s]);
+        numerrors += denormalCompare(sets[s]);
+    }
+    printf("\n\nDenormal test of test case %i, %s, instruction set %i", testcase, TOSTRING(vtype), INSTRSET);
+    printf("\n%-10s", "");
+    for (s = 0; s < 2; s++) printf("| %-9s data: %5i inputs               ", sets[s].name, sets[s].num);
+    printf("\n%-10s", "mode");
+    for (s = 0; s < 2; s++) printf("|  max ULP  mean ULP   changed    clocks ");
+    FILE * ff = fopen(STATFILE, "a");
+    for (m = 0; m < numDenormalModes; m++) {
+        printf("\n%-10s", denormalModeNames[m]);
+        for (s = 0; s < 2; s++) {
+            DenormalSet const & d = sets[s];
+            printf("| %8.3G %9.3G %9llu %9.2f ", d.stat[m].maxdif, d.stat[m].mean(), 
+                (unsigned long long)d.changed[m], d.clocks[m]);
+            if (ff) {
+                fprintf(ff, "denormal,%i,%s,%i,%s,%s,%i,%.6G,%.6G,%llu,%.3f\n", testcase, TOSTRING(vtype), 
+                    INSTRSET, denormalModeNames[m], d.name, d.num, d.stat[m].maxdif, d.stat[m].mean(),
+                    (unsigned long long)d.changed[m], d.clocks[m]);
+            }
+        }
+    }
+    if (ff) fclose(ff);
+    printf("\nchanged = number of results different from default mode. clocks = clock cycles per element");
+    printf("\nSlowdown of subnormal data: %.2f in default mode, %.2f with FTZ+DAZ\n", 
+        subnormal.clocks[0] / normal.clocks[0], subnormal.clocks[3] / normal.clocks[3]);
+    stat.merge(normal.stat[0]);
+    stat.merge(subnormal.stat[0]);
+    return numerrors;
+}
+#endif  // DENORMAL_TEST
+
 
 // program entry
 int main(int argc, char* argv[]) {
     vtype a, b;                        // operand vectors
     rtype result;                      // result vector
     //rtype expected;                    // expected result
-    const int vectorsize = sizeof(vtype) / sizeof(decltype(a[0]));
-    bool ignore;                       // ignore certain error conditions
-    int sign_error = 0;                // results have different sign bit
 
 #ifdef _FPU_CONTROL_H
     // The floating point control word is wrong in WSL. This gives poor 
@@ -1488,17 +3407,48 @@ int main(int argc, char* argv[]) {
     _FPU_SETCW(cw);
 #endif
 
-    // make lists of test data
-    TestData<ST> adata;                // test data for first parameter
+    // make lists of test data. Static because the list can be big with BUCKET_SAMPLES
+    static TestData<ST> adata(true);   // test data for first parameter
 
+    double maxdif = 0;                 // maximum error found
+    ErrorStatistics stat;              // histogram of errors and worst results
+
+#if !defined(EXHAUSTIVE_TEST) && !defined(GRID_TEST) && !defined(DENORMAL_TEST)  // test with list of data
+    const int vectorsize = sizeof(vtype) / sizeof(decltype(a[0]));
     // list for expected results
     // decltype(result[0]) expectedList[vectorsize];
     long double expectedList[vectorsize];
 
     int i, k;   // loop counters
-    double dif = 0, maxdif = 0;        // maximum error found
+    double dif = 0;                    // error of one result
+    bool ignore;                       // ignore certain error conditions
+    int sign_error = 0;                // results have different sign bit
+#endif
 
-#ifndef TWO_PARAMETERS                 // has one parameter
+#if defined(EXHAUSTIVE_TEST)            // test all float inputs
+
+    uint64_t numerrors = exhaustiveTest(argc > 1 ? atoi(argv[1]) : 0, stat);
+    numerr = numerrors > 0x7FFFFFFF ? 0x7FFFFFFF : int(numerrors);
+    maxdif = stat.maxdif;
+
+#elif defined(GRID_TEST)                // test two-parameter function on grids
+
+    uint64_t numerrors = gridTest(argc > 1 ? atoi(argv[1]) : 0, stat);
+    numerr = numerrors > 0x7FFFFFFF ? 0x7FFFFFFF : int(numerrors);
+    maxdif = stat.maxdif;
+
+#elif defined(DENORMAL_TEST)            // test with FTZ and DAZ modes
+
+    uint64_t numerrors = denormalTest(adata, stat);
+    numerr = numerrors > 0x7FFFFFFF ? 0x7FFFFFFF : int(numerrors);
+    maxdif = stat.maxdif;
+
+#elif !defined(TWO_PARAMETERS)         // has one parameter
+
+#ifdef REFERENCE_CACHE
+    ReferenceCache refcache;           // reference values from file
+    const long double * cachedReference = refcache.get(adata.list, adata.size());
+#endif
 
     for (i = 0; i < adata.size(); i += vectorsize) {
         a.load(adata.list + i);
@@ -1509,7 +3459,12 @@ int main(int argc, char* argv[]) {
 
         // expected value to compare with
         for (k = 0; k < vectorsize; k++) {
+#ifdef REFERENCE_CACHE
+            expectedList[k] = cachedReference[i + k];
+            x0 = adata.list[i + k];    // used with IGNORE_UNDERFLOW
+#else
             expectedList[k] = referenceFunction(adata.list[i + k]);
+#endif
             ignore = false;
             // compare result with expected value
             dif = compare_scalars(result[k], expectedList[k]);
@@ -1523,11 +3478,15 @@ int main(int argc, char* argv[]) {
                 if (numerr > maxerrors) break;
             }
             if (dif > maxdif && !ignore && result[k] != expectedList[k]) maxdif = dif;
+            stat.add(result[k] != expectedList[k] ? dif : 0., ignore, a[k], 0., result[k], expectedList[k]);
         }
         if (numerr > maxerrors) break;
     }
+#ifdef BENCHMARK
+    benchmark(adata.list, adata.size(), 0, 0, stat);
+#endif
 #else      // two parameters
-    TestData<ST> bdata;                // test data for second parameter
+    static TestData<ST> bdata;         // test data for second parameter
 
     for (i = 0; i < adata.size(); i += vectorsize) {
         a.load(adata.list + i);
@@ -1559,6 +3518,7 @@ int main(int argc, char* argv[]) {
                     if (numerr > maxerrors) break;
                 }
                 if (dif > maxdif && !ignore && result[k] != expectedList[k]) maxdif = dif;
+                stat.add(result[k] != expectedList[k] ? dif : 0., ignore, a[k], b[k], result[k], expectedList[k]);
             }
             if (numerr > maxerrors) {
                 i = adata.size();
@@ -1566,15 +3526,22 @@ int main(int argc, char* argv[]) {
             }
         }
     }
+#ifdef BENCHMARK
+    benchmark(adata.list, adata.size(), bdata.list, bdata.size(), stat);
+#endif
 
 #endif  // two parameters
 
 
+#ifdef ERROR_STATISTICS
+    stat.print();
+    stat.writeFile(STATFILE);
+#endif
     printf("\nAccuracy = %.2G ULP\n\n", maxdif);
     if (maxdif <= FACCURACY) {
         numerr = 0;         // report success if accuracy is as desirec
     }
-#ifdef SIGNED_ZERO
+#if defined(SIGNED_ZERO) && !defined(EXHAUSTIVE_TEST) && !defined(GRID_TEST) && !defined(DENORMAL_TEST)
     numerr += sign_error;   // count errors in signed zero
 #endif
 
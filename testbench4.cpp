@@ -1,7 +1,7 @@
 /****************************  testbench4.cpp   *******************************
 * Author:        Agner Fog
 * Date created:  2019-04-09
-* Last modified: 2026-04-10
+* Last modified: 2026-10-19
 * Version:       2.02.03
 * Project:       Testbench for vector class library
 * Description:
@@ -32,6 +32,61 @@
 *           8:  AVX2
 *           9:  AVX512F
 *           10: AVX512BW/DQ/VL
+* EXHAUSTIVE_TEST: Optional. Test all 65536 half precision inputs, with a and b equal.
+* EXHAUSTIVE_PAIRS: Optional. Test all 2^32 pairs of half precision inputs for an
+*           element-wise function with two parameters. The work is distributed between
+*           threads. The number of threads can be specified on the command line:
+*           testbench4 [nthreads]. Default = all hardware threads.
+*           mul_add, mul_sub, and nmul_add (530 - 532) are tested with a random third operand.
+* PAIRS_ROWS: Optional with EXHAUSTIVE_PAIRS. Number of values of the first operand to test,
+*           evenly spaced. Must be a power of 2. Default 65536 = all
+* ULP_TABLE: Optional. Test the mathematical functions 519, 550 - 553, 560 - 562, and 570 - 572
+*           with all 65536 half precision inputs and vector types Vec8h, Vec16h, and Vec32h.
+*           Print a table of max ULP error, number of results that are not correctly rounded,
+*           and the input with the biggest error, for each function and vector size.
+*           testcase and vtype are not used, except that they must compile.
+* BENCHMARK: Optional. Measure the speed of the test function over the same combinations
+*           of test data as in the test. The clock cycles per element are printed and appended
+*           to the file BENCHFILE as comma-separated lines:
+*           testcase,vtype,rtype,INSTRSET,native_fp16,clocks,emulated
+*           native_fp16 is 1 if AVX512-FP16 instructions are used (INSTRSET 12), and 0 if 
+*           half precision is emulated with float instructions.
+*           Use fp16report.sh to compare emulated and native half precision.
+* BENCHFILE: Optional. Name of benchmark file. Default "bench4.csv"
+* BENCHREPEAT: Optional. Number of repetitions of benchmark. The fastest is used. Default 20
+* CONVERSION_BENCHMARK: Optional. Measure the throughput of conversion of arrays with
+*           Vec16h -> Vec16f and Vec16f -> Vec16h for array sizes from 4096 elements (L1 cache)
+*           to CONVERSION_MAXSIZE elements, with aligned arrays and with unaligned arrays that
+*           end with a partial vector. Print GB/s and elements per clock and append the results
+*           to CONVERSION_FILE (default "conv4.csv"). testcase and vtype are not used.
+* CONVERSION_MAXSIZE: Optional. Max number of elements in array. Default 2^24, which is 96 MB
+* SUM_TEST: Optional. Measure the accuracy and speed of different methods for summing long
+*           arrays of half precision numbers with Vec8h, Vec16h, and Vec32h: horizontal_add of
+*           each vector, half precision vector accumulator, pairwise tree, horizontal_add_x, and
+*           float vector accumulator. The error is relative to the exact sum. The results are 
+*           printed and appended to SUM_FILE (default "sum4.csv"). testcase and vtype are not used.
+* SUM_MAXSIZE: Optional. Max number of elements in array. Must be a power of 2. Default 2^22
+* MASK_TEST: Optional. Test the classification functions 210 - 214 and sign_bit with all 65536
+*           inputs, and the comparison operators 300 - 305 with all 2^32 pairs of inputs, for
+*           vtype. The boolean results are compared with the expected results as bit masks with
+*           to_bits. The comparisons are distributed between threads: testbench4 [nthreads].
+*           Then the clock cycles per vector are measured for each function with the result
+*           used as a bit mask and in select. The boolean vectors are compact bit masks with 
+*           AVX512 (INSTRSET >= 10) and broadcast vectors with lower instruction sets. 
+*           testcase is not used.
+* MASK_ROWS: Optional with MASK_TEST. Number of values of the first operand in comparisons,
+*           evenly spaced. Must be a power of 2. Default 65536 = all
+* FMA_TEST: Optional. Test if mul_add, mul_sub, and nmul_add are rounded only once, with 
+*           vtype. The triples of inputs are made so that the exact result is close to the 
+*           midpoint between two half precision numbers. Some of them are rounded to exactly
+*           the midpoint when calculated via float. The rate of wrong results, the rate of
+*           results that are rounded twice, and the clock cycles per element are printed.
+*           The work is distributed between threads: testbench4 [nthreads]. 
+*           testcase is not used.
+* FMA_TRIPLES: Optional with FMA_TEST. Number of triples for each function. 
+*           Must be a multiple of 65536. Default 2^30
+* EMULATED: Defined by runtest.sh when the program runs in the emulator because the instruction
+*           set is not supported by the CPU. The benchmark clock counts are not valid then.
 *
 * Compile with any compiler supported by VCL.
 * Specify the desired instruction set and optimization options as parameters
@@ -154,6 +209,35 @@ Test cases:
 
 #include <stdio.h>
 #include <cmath>
+#ifdef EXHAUSTIVE_PAIRS
+#include <stdlib.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#endif
+#ifdef ULP_TABLE
+#include <stdlib.h>
+#include <chrono>
+#endif
+#ifdef CONVERSION_BENCHMARK
+#include <stdlib.h>
+#include <chrono>
+#endif
+#if defined(MASK_TEST) || defined(FMA_TEST)
+#include <stdlib.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#endif
+#if defined(BENCHMARK) || defined(CONVERSION_BENCHMARK) || defined(SUM_TEST) || defined(MASK_TEST) || defined(FMA_TEST)
+#ifdef _MSC_VER
+#include <intrin.h>               // __rdtsc
+#else
+#include <x86intrin.h>            // __rdtsc
+#endif
+#endif
 #if defined (__linux__) && !defined(__LP64__)
 #include <fpu_control.h>     // set floating point control word
 #endif
@@ -236,6 +320,9 @@ typedef decltype(dummyr[0]) RT;   // scalar type for return vector
 
 const int maxvectorsize = 64;     // max number of elements in a vector
 
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
 uint64_t bitfield;                // integer for load_bits function
 
 
@@ -406,6 +493,73 @@ uint16_t fp162half (Float16 x) {
 }
 
 
+// ----------------------------------------------------------------------------
+//                 conversion of blocks of Float16 <-> float
+// ----------------------------------------------------------------------------
+
+// These functions convert the inputs and results of reference functions calculated
+// with float precision (FLOAT_REFERENCE) in blocks rather than one element at a time.
+// They use F16C or AVX512 instructions if available. Otherwise, half to float conversion 
+// uses a table of all 65536 values, and float to half conversion uses to_float16 in this 
+// file rather than the Float16 constructor of VCL. This applies also to the MS compiler,
+// which does not define __F16C__
+
+#ifndef __F16C__
+// table of all half precision values converted to float
+struct HalfTable {
+    float f[0x10000];
+    HalfTable() {
+        for (uint32_t i = 0; i < 0x10000; i++) f[i] = to_float(i);
+    }
+};
+
+// get table. It is made the first time, also when called from multiple threads
+float const * halfTable() {
+    static HalfTable table;
+    return table.f;
+}
+#endif
+
+// convert n half precision numbers to float
+void to_float_block(void const * src, float * dst, int n) {
+    uint16_t const * s = (uint16_t const *)src;
+    int i = 0;
+#if INSTRSET >= 9
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(_mm256_loadu_si256((__m256i const *)(s + i))));
+    }
+#endif
+#ifdef __F16C__
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((__m128i const *)(s + i))));
+    }
+    for (; i < n; i++) dst[i] = _cvtsh_ss(s[i]);
+#else
+    float const * table = halfTable();
+    for (; i < n; i++) dst[i] = table[s[i]];
+#endif
+}
+
+// convert n float numbers to half precision. Round to nearest or even
+void to_float16_block(float const * src, void * dst, int n) {
+    uint16_t * d = (uint16_t *)dst;
+    int i = 0;
+#if INSTRSET >= 9
+    for (; i + 16 <= n; i += 16) {
+        _mm256_storeu_si256((__m256i *)(d + i), _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+#ifdef __F16C__
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_si128((__m128i *)(d + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+    for (; i < n; i++) d[i] = _cvtss_sh(src[i], _MM_FROUND_TO_NEAREST_INT);
+#else
+    for (; i < n; i++) d[i] = to_float16(src[i]);
+#endif
+}
+
+
 bool signbit_(float x) {
     union { float f; uint32_t i; } u;
     u.f = x; return u.i >> 31 != 0;
@@ -419,6 +573,118 @@ bool signbit_(Float16 x) {
 }
 
 
+// ----------------------------------------------------------------------------
+//         Reference functions for half precision mathematical functions
+// ----------------------------------------------------------------------------
+
+// These functions are calculated with float precision. They are used by the test 
+// cases and by ULP_TABLE
+
+float referenceSqrt(float x) {
+    return sqrtf(x);
+}
+
+float referenceExp(float x) {
+#ifdef __AVX512FP16__    // intermediate calculations with half precision
+    float maxexp = 10.75f;
+#else
+    float maxexp = 1000.f;
+#endif
+    if (x >= maxexp) return INFINITY;
+    return expf(x);
+}
+
+float referenceExp2(float x) {
+#ifdef __AVX512FP16__    // intermediate calculations with half precision
+    float maxexp = 15.5f;
+#else
+    float maxexp = 1000.f;
+#endif
+    if (x >= maxexp) return INFINITY;
+    return exp2f(x);
+}
+
+float referenceExp10(float x) {
+#ifdef __AVX512FP16__    // intermediate calculations with half precision
+    float maxexp = 4.667f;
+#else
+    float maxexp = 1000.f;
+#endif
+    if (x >= maxexp) return INFINITY;
+    return powf(10.f, x);
+}
+
+float referenceExpm1(float x) {
+#ifdef __AVX512FP16__    // intermediate calculations with half precision
+    float maxexp = 10.75f;
+#else
+    float maxexp = 1000.f;
+#endif
+    if (x >= maxexp) return INFINITY;
+    return expm1f(x);
+}
+
+float referenceSin(float x) {
+    // limit
+    float sinlimit = 314.25;
+    //if ((fp162half(x) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
+    if (std::fabs(x) > sinlimit) return 0;
+    return sinf(x);
+}
+
+float referenceCos(float x) {
+    // limit
+    float sinlimit = 314.25;
+    //if ((fp162half(x) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
+    if (std::fabs(x) > sinlimit) return 1.;
+    return cosf(x);
+}
+
+float referenceTan(float x) {
+    // limit
+    float sinlimit = 314.25;
+    //if ((fp162half(x) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
+    if (std::fabs(x) > sinlimit) return 0.;
+    return tanf(x);
+}
+
+float referenceSinpi(float x) {
+    // limit
+#ifdef __AVX512FP16__
+    if (fabs(x) > 32000) return 0; // overflow -> 0
+#else
+    if (std::isinf(x)) return NAN;   // INF -> NAN
+#endif
+    return (float)sinl(x*3.14159265358979323846);
+}
+
+float referenceCospi(float x) {
+    // limit
+#ifdef __AVX512FP16__
+    if (fabs(x) > 32000) return 1.; // overflow -> 1
+#else
+    if (std::isinf(x)) return NAN;   // INF -> NAN
+#endif
+    return (float)cosl(x*3.14159265358979323846);
+}
+
+float referenceTanpi(float x) {
+    // limit
+#ifdef __AVX512FP16__
+    if (fabs(x) > 32000) return 0;; // overflow -> 0
+#else
+    if (std::isinf(x)) return NAN;   // INF -> NAN
+#endif
+
+    int64_t ia2 = int64_t(x * 2.);
+    if (ia2 == x * 2.) {  // sign of INF result should alternate according to IEEE 754-2019
+        if ((ia2 & 3) == 1) return INFINITY;
+        if ((ia2 & 3) == 3) return -INFINITY;
+    } 
+    return (float)tanl(x*3.14159265358979323846);
+}
+
+
 /************************************************************************
 *
 *                          Test cases
@@ -993,49 +1259,67 @@ RT referenceFunction(ST a, ST b) {
 
 #elif testcase == 519    // sqrt
 inline rtype testFunction(vtype const& a, vtype const& b) { return sqrt(a); }
-RT referenceFunction(ST a, ST b) {
-    float c = sqrtf(float(a));
-    return RT(c);
+float referenceFloat(float a, float b) {
+    return referenceSqrt(a);
 }
+#define FLOAT_REFERENCE
 
 #elif testcase == 520    // approx_recipr
 inline rtype testFunction(vtype const& a, vtype const& b) { return approx_recipr(a); }
-RT referenceFunction(ST a, ST b) {
-    float c = 1.0f / float(a);
-    return RT(c);
+float referenceFloat(float a, float b) {
+    return 1.0f / a;
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 1      // accept  rounding errors
 
 #elif testcase == 521    // approx_rsqrt
 inline rtype testFunction(vtype const& a, vtype const& b) { return approx_rsqrt(a); }
-RT referenceFunction(ST a, ST b) {
-    float c = 1.0 / sqrt(double(a));
-    return RT(c);
+float referenceFloat(float a, float b) {
+    return float(1.0 / sqrt(double(a)));
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 1      // accept  rounding errors
 
 #elif testcase == 530    // mul_add
 inline rtype testFunction(vtype const& a, vtype const& b) { return mul_add(a, b, vtype(1.f)); }
-RT referenceFunction(ST a, ST b) {
-    float c = float(a) * float(b) + 1.0f;
-    return RT(c);
+float referenceFloat(float a, float b) {
+    return a * b + 1.0f;
+}
+// variable third operand, used with EXHAUSTIVE_PAIRS
+inline rtype testFunction3(vtype const& a, vtype const& b, vtype const& c) { return mul_add(a, b, c); }
+float referenceFloat3(float a, float b, float c) {
+    return a * b + c;
 }
+#define FLOAT_REFERENCE
+#define THIRD_OPERAND
 #define FACCURACY 2      // accept  rounding errors
 
 #elif testcase == 531    // mul_sub
 inline rtype testFunction(vtype const& a, vtype const& b) { return mul_sub(a, vtype(1.25f), b); }
-RT referenceFunction(ST a, ST b) {
-    float c = float(a) * 1.25f - float(b);
-    return RT(c);
+float referenceFloat(float a, float b) {
+    return a * 1.25f - b;
+}
+// variable third operand, used with EXHAUSTIVE_PAIRS
+inline rtype testFunction3(vtype const& a, vtype const& b, vtype const& c) { return mul_sub(a, b, c); }
+float referenceFloat3(float a, float b, float c) {
+    return a * b - c;
 }
+#define FLOAT_REFERENCE
+#define THIRD_OPERAND
 #define FACCURACY 2      // accept  rounding errors
 
 #elif testcase == 532    // nmul_add
 inline rtype testFunction(vtype const& a, vtype const& b) { return nmul_add(vtype(2.25f), a, b); }
-RT referenceFunction(ST a, ST b) {
-    float c = -2.25f * float(a) + float(b);
-    return RT(c);
+float referenceFloat(float a, float b) {
+    return -2.25f * a + b;
 }
+// variable third operand, used with EXHAUSTIVE_PAIRS
+inline rtype testFunction3(vtype const& a, vtype const& b, vtype const& c) { return nmul_add(a, b, c); }
+float referenceFloat3(float a, float b, float c) {
+    return -a * b + c;
+}
+#define FLOAT_REFERENCE
+#define THIRD_OPERAND
 #define FACCURACY 2      // accept  rounding errors
 
 #elif testcase == 540    // exponent
@@ -1085,17 +1369,10 @@ RT referenceFunction(ST a, ST b) {
 
 #elif testcase == 550    // exp
 inline rtype testFunction(vtype const& a, vtype const& b) { return exp(b); }
-RT referenceFunction(ST a, ST b) {
-#ifdef __AVX512FP16__    // intermediate calculations with half precision
-    float maxexp = 10.75f;
-#else
-    float maxexp = 1000.f;
-#endif
-    if (float(b) >= maxexp) return half2fp16(0x7C00); // INF
-    float bf = float(b);
-    float y = expf(bf);
-    return y;
+float referenceFloat(float a, float b) {
+    return referenceExp(b);
 }
+#define FLOAT_REFERENCE
 #ifdef __AVX512FP16__    // intermediate calculations with half precision
 #define FACCURACY 7      // accept accumulating rounding errors
 #else                    // intermediate calculations with float precision
@@ -1106,16 +1383,10 @@ RT referenceFunction(ST a, ST b) {
 #elif testcase == 551    // exp2
 
 inline rtype testFunction(vtype const& a, vtype const& b) { return exp2(b); }
-RT referenceFunction(ST a, ST b) {
-#ifdef __AVX512FP16__    // intermediate calculations with half precision
-    float maxexp = 15.5f;
-#else
-    float maxexp = 1000.f;
-#endif
-    if (float(b) >= maxexp) return half2fp16(0x7C00); // INF
-
-    return exp2f(float(b));
+float referenceFloat(float a, float b) {
+    return referenceExp2(b);
 }
+#define FLOAT_REFERENCE
 #ifdef __AVX512FP16__    // intermediate calculations with half precision
 #define FACCURACY 6      // accept accumulating rounding errors
 #else                    // intermediate calculations with float precision
@@ -1125,15 +1396,10 @@ RT referenceFunction(ST a, ST b) {
 
 #elif testcase == 552    // exp10
 inline rtype testFunction(vtype const& a, vtype const& b) { return exp10(b); }
-RT referenceFunction(ST a, ST b) {
-#ifdef __AVX512FP16__    // intermediate calculations with half precision
-    float maxexp = 4.667f;
-#else
-    float maxexp = 1000.f;
-#endif
-    if (float(b) >= maxexp) return half2fp16(0x7C00); // INF
-    return powf(10.f, float(b));
+float referenceFloat(float a, float b) {
+    return referenceExp10(b);
 }
+#define FLOAT_REFERENCE
 #ifdef __AVX512FP16__    // intermediate calculations with half precision
 #define FACCURACY 6      // accept accumulating rounding errors
 #else                    // intermediate calculations with float precision
@@ -1144,15 +1410,10 @@ RT referenceFunction(ST a, ST b) {
 #elif testcase == 553    // expm1
 
 inline rtype testFunction(vtype const& a, vtype const& b) { return expm1(b); }
-RT referenceFunction(ST a, ST b) {
-#ifdef __AVX512FP16__    // intermediate calculations with half precision
-    float maxexp = 10.75f;
-#else
-    float maxexp = 1000.f;
-#endif
-    if (float(b) >= maxexp) return half2fp16(0x7C00); // INF
-    return expm1f(float(b));
+float referenceFloat(float a, float b) {
+    return referenceExpm1(b);
 }
+#define FLOAT_REFERENCE
 #ifdef __AVX512FP16__    // intermediate calculations with half precision
 #define FACCURACY 7      // accept accumulating rounding errors
 #else                    // intermediate calculations with float precision
@@ -1162,25 +1423,19 @@ RT referenceFunction(ST a, ST b) {
 
 #elif testcase == 560   //  sin
 inline rtype testFunction(vtype const& a, vtype const& b) { return sin(b); }
-RT referenceFunction(ST a, ST b) {
-    // limit
-    float sinlimit = 314.25;
-    //if ((fp162half(b) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
-    if (abs(float(b)) > sinlimit) return 0;
-    return sinf(float(b));
+float referenceFloat(float a, float b) {
+    return referenceSin(b);
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 6      // accept accumulating rounding errors
 #define IGNORE_SUBNORMAL
 
 #elif testcase == 561   //  cos
 inline rtype testFunction(vtype const& a, vtype const& b) { return cos(b); }
-RT referenceFunction(ST a, ST b) {
-    // limit
-    float sinlimit = 314.25;
-    //if ((fp162half(b) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
-    if (abs(float(b)) > sinlimit) return 1.;
-    return cosf(float(b));
+float referenceFloat(float a, float b) {
+    return referenceCos(b);
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 12      // accept accumulating rounding errors
 #define IGNORE_SUBNORMAL
 
@@ -1188,13 +1443,10 @@ RT referenceFunction(ST a, ST b) {
 inline rtype testFunction(vtype const& a, vtype const& b) { 
     return tan(b); 
 }
-RT referenceFunction(ST a, ST b) {
-    // limit
-    float sinlimit = 314.25;
-    //if ((fp162half(b) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
-    if (abs(float(b)) > sinlimit) return 0.;
-    return tanf(float(b));
+float referenceFloat(float a, float b) {
+    return referenceTan(b);
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 1000      // rounding errors are high for high x
 #define IGNORE_SUBNORMAL
 
@@ -1204,7 +1456,7 @@ inline rtype testFunction(vtype const& a, vtype const& b) {
     s = sincos(&c, b);
     return select(b >= vtype(ST(0)), s, c);
 }
-RT referenceFunction(ST a, ST b) {
+float referenceFloat(float a, float b) {
     float s = sinf(b);
     float c = cosf(b);
     // limit
@@ -1213,60 +1465,40 @@ RT referenceFunction(ST a, ST b) {
         //c = s = half2fp16(0x7E00); // INF -> NAN
     }
     else */
-    if (abs(float(b)) > sinlimit) {
+    if (std::fabs(b) > sinlimit) {
         s = 0; c = 1;
     }  
-    return b >= ST(0) ? s : c;
+    return b >= 0.f ? s : c;
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 12      // accept accumulating rounding errors
 #define IGNORE_SUBNORMAL
 
 
 #elif testcase == 570   // sinpi
 inline rtype testFunction(vtype const& a, vtype const& b) { return sinpi(b); }
-RT referenceFunction(ST a, ST b) {
-    // limit
-#ifdef __AVX512FP16__
-    if (fabs(b) > 32000) return 0; // overflow -> 0
-#else
-    if ((fp162half(b) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
-#endif
-    return (float)sinl(float(b)*3.14159265358979323846);
+float referenceFloat(float a, float b) {
+    return referenceSinpi(b);
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 2       // accept accumulating rounding errors
 #define IGNORE_SUBNORMAL
 
 #elif testcase == 571   // cospi
 inline rtype testFunction(vtype const& a, vtype const& b) { return cospi(b); }
-RT referenceFunction(ST a, ST b) {
-    // limit
-#ifdef __AVX512FP16__
-    if (fabs(b) > 32000) return 1.; // overflow -> 1
-#else
-    if ((fp162half(b) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
-#endif
-    return (float)cosl(float(b)*3.14159265358979323846);
+float referenceFloat(float a, float b) {
+    return referenceCospi(b);
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 2       // accept accumulating rounding errors
 #define IGNORE_SUBNORMAL
 
 #elif testcase == 572   // tanpi
 inline rtype testFunction(vtype const& a, vtype const& b) { return tanpi(b); }
-RT referenceFunction(ST a, ST b) {
-    // limit
-#ifdef __AVX512FP16__
-    if (fabs(b) > 32000) return 0;; // overflow -> 0
-#else
-    if ((fp162half(b) & 0x7FFF) == 0x7C00) return half2fp16(0x7E00); // INF -> NAN
-#endif
-
-    int64_t ia2 = int64_t(float(b) * 2.);
-    if (ia2 == float(b) * 2.) {  // sign of INF result should alternate according to IEEE 754-2019
-        if ((ia2 & 3) == 1) return half2fp16(0x7C00); //  INF
-        if ((ia2 & 3) == 3) return half2fp16(0xFC00); // -INF
-    } 
-    return (float)tanl(float(b)*3.14159265358979323846);
+float referenceFloat(float a, float b) {
+    return referenceTanpi(b);
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 4       // accept accumulating rounding errors
 #define IGNORE_SUBNORMAL
 
@@ -1276,21 +1508,22 @@ inline rtype testFunction(vtype const& a, vtype const& b) {
     s = sincospi(&c, b);
     return select(b >= vtype(ST(0)), s, c);
 }
-RT referenceFunction(ST a, ST b) {
-    float s = (float)sin(float(b)*3.14159265358979323846);
-    float c = (float)cos(float(b)*3.14159265358979323846);
+float referenceFloat(float a, float b) {
+    float s = (float)sin(b*3.14159265358979323846);
+    float c = (float)cos(b*3.14159265358979323846);
     // limit
 #ifdef __AVX512FP16__
     if (fabs(b) > 32000) {
         s = 0; c = 1;
     }
 #else
-    if ((fp162half(b) & 0x7FFF) == 0x7C00) {
-        c = s = half2fp16(0x7E00); // INF -> NAN
+    if (std::isinf(b)) {
+        c = s = NAN;     // INF -> NAN
     }
 #endif
-    return b >= ST(0) ? s : c;
+    return b >= 0.f ? s : c;
 }
+#define FLOAT_REFERENCE
 #define FACCURACY 2      // accept accumulating rounding errors
 #define IGNORE_SUBNORMAL
 
@@ -1990,15 +2223,16 @@ double delta_unit(double x) {
 #endif
 
 
-// compare two scalars. return true if different
+// compare two scalars. return true if different.
+// quiet = true: do not print the difference in ULP
 template <typename T>
-inline bool compare_scalars(T const a, T const b) {
+inline bool compare_scalars(T const a, T const b, bool quiet = false) {
     return a == b;
 }
 
 // special cass for Float16:
 template <>
-inline bool compare_scalars<Float16>(Float16 const a, Float16 const b) {
+inline bool compare_scalars<Float16>(Float16 const a, Float16 const b, bool quiet) {
     uint16_t aa = castfp162s(a);
     uint16_t bb = castfp162s(b);
     if ((aa & 0x7FFF) == 0 && (bb & 0x7FFF) == 0) return true;  // both are zero except for sign bit
@@ -2015,25 +2249,25 @@ inline bool compare_scalars<Float16>(Float16 const a, Float16 const b) {
 #ifdef FACCURACY     // accept minor difference
     int dif = abs(aa - bb);
     if (dif <= FACCURACY) return true;
-    printf("\n%i ULP ", dif);
+    if (!quiet) printf("\n%i ULP ", dif);
 #endif
     return false;
 }
 
 // special cases for float and double:
 template <>
-inline bool compare_scalars<float>(float const a, float const b) {
+inline bool compare_scalars<float>(float const a, float const b, bool quiet) {
     if (a == b || (a != a && b != b)) return true; // return false if equal or both are NAN
 #ifdef FACCURACY     // accept minor difference
     float dif = std::fabs(a - b) / delta_unit(a);
     if (dif <= FACCURACY) return true;
-    printf("\n%.0f ULP ", dif);
+    if (!quiet) printf("\n%.0f ULP ", dif);
 #endif
     return false;
 }
 
 template <>
-inline bool compare_scalars<double>(double const a, double const b) {
+inline bool compare_scalars<double>(double const a, double const b, bool quiet) {
     if (a == b || (a != a && b != b)) return true; // return false if equal or both are NAN
 #ifdef FACCURACY     // accept minor difference
     double dif = std::fabs(a - b) / delta_unit(a);
@@ -2055,9 +2289,1255 @@ inline bool compare_vectors(T const& a, T const& b) {
     return true;
 }
 
+#ifdef EXHAUSTIVE_PAIRS
+// ----------------------------------------------------------------------------
+//         Test all pairs of half precision inputs, distributed between threads
+// ----------------------------------------------------------------------------
+#if defined(EXHAUSTIVE_TEST) || defined(USE_FLAG) || defined(SCALAR_RESULT) || defined(WHOLE_VECTOR)
+#error EXHAUSTIVE_PAIRS is only for element-wise functions with two parameters
+#endif
+static_assert(sizeof(ST) == 2, "EXHAUSTIVE_PAIRS requires half precision input");
+
+#ifndef PAIRS_ROWS
+#define PAIRS_ROWS 0x10000   // number of values of the first operand to test
+#endif
+static_assert(PAIRS_ROWS > 0 && PAIRS_ROWS <= 0x10000 && (0x10000 % PAIRS_ROWS) == 0, 
+    "PAIRS_ROWS must be a power of 2 <= 65536");
+
+ST allHalves[0x10000 + maxvectorsize];           // all half precision bit patterns
+#ifdef FLOAT_REFERENCE
+float allFloats[0x10000 + maxvectorsize];        // all half precision values converted to float
+#endif
+std::atomic<int> nextPairsRow(0);                // next row of work
+std::atomic<int> pairsReported(0);               // number of errors reported
+std::mutex printMutex;                           // prevent threads from printing at the same time
+
+// results from one thread
+struct PairsResult {
+    uint64_t count = 0;                          // number of pairs tested
+    uint64_t numerrors = 0;                      // number of wrong results
+};
+
+#ifdef FACCURACY
+// difference in ULP between result and expected value, for error reports.
+// Returns -1 if not defined for type T
+template <typename T>
+double ulpDifference(T r, T e) {
+    return -1.;
+}
+
+template <>
+double ulpDifference<Float16>(Float16 r, Float16 e) {
+    return abs(int(castfp162s(r)) - int(castfp162s(e)));
+}
+
+template <>
+double ulpDifference<float>(float r, float e) {
+    return std::fabs(r - e) / delta_unit(e);
+}
+#endif
+
+// report error in exhaustive pairs test. Only the first maxerrors errors are printed
+void pairsErrorReport(ST a, ST b, ST const * c, RT r, RT e) {
+    if (pairsReported >= maxerrors) return;      // check first to avoid overflow of counter
+    int n = pairsReported++;
+    if (n >= maxerrors) return;                  // avoid locking for each error
+    std::lock_guard<std::mutex> lock(printMutex);
+    if (++numerr == 1) {
+        printf("\ntest case %i:", testcase);     // print test case first time
+    }
+    printf("\nError at a = 0x%04X, b = 0x%04X", fp162half(a), fp162half(b));
+    if (c) printf(", c = 0x%04X", fp162half(*c));
+    printf(": ");
+    printVal(a); printf(", "); printVal(b);
+    if (c) {
+        printf(", "); printVal(*c);
+    }
+    printf(" -> "); printVal(r); printf(" != "); printVal(e);
+#ifdef FACCURACY
+    double ulp = ulpDifference(r, e);
+    if (ulp >= 0.) printf(", %.0f ULP", ulp);
+#endif
+}
+
+// test rows of pairs until all rows are done.
+// Row n has the first operand a = n + k in vector element k, and the second operand 
+// runs through all 65536 values, so that each pair is tested once in each row of 
+// a = n. The third operand of mul_add etc. is random.
+// Reference functions with float precision are calculated from a table of all 
+// inputs converted to float, and the results are converted to half in blocks
+void pairsThread(PairsResult * res) {
+    constexpr int vectorsize = vtype::size();
+    vtype a, b;                                  // operand vectors
+    rtype result;                                // result vector
+    ST alist[vectorsize];                        // first operand
+    RT expectedList[vectorsize];                 // expected results
+#ifdef FLOAT_REFERENCE
+    float aFloat[vectorsize];                    // first operand converted to float
+    float expectedFloat[vectorsize];             // expected results before conversion to half
+#endif
+#ifdef THIRD_OPERAND
+    vtype c;                                     // third operand
+    ST clist[vectorsize];
+    float cFloat[vectorsize];
+#endif
+    const int rowstep = 0x10000 / PAIRS_ROWS;    // step between rows tested
+    int k;
+    while (true) {
+        int row = nextPairsRow++;                // get next row of work
+        if (row >= PAIRS_ROWS) break;            // finished
+        int first = row * rowstep;
+        for (k = 0; k < vectorsize; k++) alist[k] = allHalves[(first + k) & 0xFFFF];
+        a.load(alist);
+#ifdef FLOAT_REFERENCE
+        to_float_block(alist, aFloat, vectorsize);
+#endif
+#ifdef THIRD_OPERAND
+        ranGen rowran(seed + first);             // random third operand, same in each run
+#endif
+        for (int j = 0; j < 0x10000; j += vectorsize) {
+            b.load(allHalves + j);
+#ifdef THIRD_OPERAND
+            for (k = 0; k < vectorsize; k++) clist[k] = half2fp16(uint16_t(rowran.next()));
+            c.load(clist);
+            result = testFunction3(a, b, c);     // function under test
+            to_float_block(clist, cFloat, vectorsize);
+            for (k = 0; k < vectorsize; k++) {
+                expectedFloat[k] = referenceFloat3(aFloat[k], allFloats[j + k], cFloat[k]);
+            }
+            to_float16_block(expectedFloat, expectedList, vectorsize);
+#elif defined(FLOAT_REFERENCE)
+            result = testFunction(a, b);         // function under test
+            for (k = 0; k < vectorsize; k++) {
+                expectedFloat[k] = referenceFloat(aFloat[k], allFloats[j + k]);
+            }
+            to_float16_block(expectedFloat, expectedList, vectorsize);
+#else
+            result = testFunction(a, b);         // function under test
+            for (k = 0; k < vectorsize; k++) {
+                expectedList[k] = referenceFunction(alist[k], allHalves[j + k]);
+            }
+#endif
+            for (k = 0; k < vectorsize; k++) {
+                if (!compare_scalars(result[k], expectedList[k], true)) {
+                    res->numerrors++;
+#ifdef THIRD_OPERAND
+                    pairsErrorReport(alist[k], allHalves[j + k], clist + k, result[k], expectedList[k]);
+#else
+                    pairsErrorReport(alist[k], allHalves[j + k], 0, result[k], expectedList[k]);
+#endif
+                }
+            }
+        }
+        res->count += 0x10000;
+    }
+}
+
+// run exhaustive pairs test in all threads. Returns number of errors
+uint64_t exhaustivePairs(int nthreads) {
+    if (nthreads <= 0) nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0) nthreads = 1;
+    for (int i = 0; i < 0x10000 + maxvectorsize; i++) allHalves[i] = half2fp16(uint16_t(i));
+#ifdef FLOAT_REFERENCE
+    to_float_block(allHalves, allFloats, 0x10000 + maxvectorsize);
+#endif
+    PairsResult * results = new PairsResult[nthreads];
+    std::thread * threads = new std::thread[nthreads];
+    auto time0 = std::chrono::steady_clock::now();
+    uint64_t count = 0, numerrors = 0;
+    int t;
+    for (t = 0; t < nthreads; t++) {
+        threads[t] = std::thread(pairsThread, results + t);
+    }
+    for (t = 0; t < nthreads; t++) {             // combine results
+        threads[t].join();
+        count += results[t].count;
+        numerrors += results[t].numerrors;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time0).count();
+    printf("\nExhaustive pairs test of test case %i, %s: %llu pairs tested in %.1f seconds, %i threads, %.3G pairs/s",
+        testcase, TOSTRING(vtype), (unsigned long long)count, seconds, nthreads, count / seconds);
+#ifdef THIRD_OPERAND
+    printf("\nThird operand is random");
+#endif
+    printf("\n%llu errors", (unsigned long long)numerrors);
+    delete[] threads;
+    delete[] results;
+    return numerrors;
+}
+#endif  // EXHAUSTIVE_PAIRS
+
+#ifdef ULP_TABLE
+// ----------------------------------------------------------------------------
+//         ULP table of mathematical functions for all half precision inputs
+// ----------------------------------------------------------------------------
+#if defined(EXHAUSTIVE_PAIRS) || defined(BENCHMARK)
+#error ULP_TABLE cannot be combined with EXHAUSTIVE_PAIRS or BENCHMARK
+#endif
+
+#ifdef __AVX512FP16__
+const bool ulpNative = true;      // intermediate calculations with half precision
+#else
+const bool ulpNative = false;     // intermediate calculations with float precision
+#endif
+
+// description of function in ULP table
+struct UlpFunction {
+    int tcase;                    // test case number
+    const char * name;            // function name
+    int limit;                    // accepted error in ULP. Same as FACCURACY of the test case
+    bool ignoreSubnormal;         // subnormal results may be flushed to zero
+};
+
+// list of functions in ULP table
+const UlpFunction ulpFunctions[] = {
+    {519, "sqrt",  0, false},
+    {550, "exp",   ulpNative ? 7 : 1, true},
+    {551, "exp2",  ulpNative ? 6 : 1, true},
+    {552, "exp10", ulpNative ? 6 : 1, true},
+    {553, "expm1", ulpNative ? 7 : 1, true},
+    {560, "sin",   6, true},
+    {561, "cos",   12, true},
+    {562, "tan",   1000, true},
+    {570, "sinpi", 2, true},
+    {571, "cospi", 2, true},
+    {572, "tanpi", 4, true}
+};
+
+// results for one function and vector size
+struct UlpResult {
+    int maxulp = 0;               // maximum error in ULP
+    int wrong = 0;                // number of results not correctly rounded
+    int nanerrors = 0;            // number of results where only one of result and expected is NAN
+    uint16_t worst = 0;           // input with maximum error
+    uint16_t worstResult = 0;     // result for worst input
+    uint16_t worstExpected = 0;   // expected result for worst input
+};
+
+// function under test with vector type V
+template <typename V>
+inline V ulpFunction(int tcase, V const& x) {
+    switch (tcase) {
+    case 519: return sqrt(x);
+    case 550: return exp(x);
+    case 551: return exp2(x);
+    case 552: return exp10(x);
+    case 553: return expm1(x);
+    case 560: return sin(x);
+    case 561: return cos(x);
+    case 562: return tan(x);
+    case 570: return sinpi(x);
+    case 571: return cospi(x);
+    case 572: return tanpi(x);
+    }
+    return x;
+}
+
+// reference function with float precision
+float ulpReference(int tcase, float x) {
+    switch (tcase) {
+    case 519: return referenceSqrt(x);
+    case 550: return referenceExp(x);
+    case 551: return referenceExp2(x);
+    case 552: return referenceExp10(x);
+    case 553: return referenceExpm1(x);
+    case 560: return referenceSin(x);
+    case 561: return referenceCos(x);
+    case 562: return referenceTan(x);
+    case 570: return referenceSinpi(x);
+    case 571: return referenceCospi(x);
+    case 572: return referenceTanpi(x);
+    }
+    return x;
+}
+
+// position of half precision number in the ordered sequence of all numbers. 
+// The distance between two positions is the error in ULP. +0 and -0 have the same position
+static inline int halfPosition(uint16_t h) {
+    return (h & 0x8000) ? -int(h & 0x7FFF) : int(h);
+}
+
+Float16 ulpInput[0x10000];        // all half precision bit patterns
+float ulpInputFloat[0x10000];     // all inputs converted to float
+float ulpExpectedFloat[0x10000];  // expected results before conversion to half
+uint16_t ulpExpected[0x10000];    // expected results
+Float16 ulpOutput[0x10000];       // results of function under test
+
+// test function with all inputs and vector type V. Compare results with ulpExpected
+template <typename V>
+void ulpRun(UlpFunction const& f, UlpResult & res) {
+    V x;
+    for (int i = 0; i < 0x10000; i += V::size()) {
+        x.load(ulpInput + i);
+        ulpFunction(f.tcase, x).store(ulpOutput + i);
+    }
+    for (int i = 0; i < 0x10000; i++) {
+        uint16_t r = fp162half(ulpOutput[i]);
+        uint16_t e = ulpExpected[i];
+        bool rnan = (r & 0x7FFF) > 0x7C00, enan = (e & 0x7FFF) > 0x7C00;
+        if (rnan && enan) continue;                      // both are NAN
+        if (rnan || enan) {                              // only one is NAN
+            res.wrong++;  res.nanerrors++;
+            continue;
+        }
+        if (f.ignoreSubnormal && (r & 0x7C00) == 0 && (e & 0x7C00) == 0) continue; // both are zero or subnormal
+        int dif = abs(halfPosition(r) - halfPosition(e));
+        if (dif == 0) continue;
+        res.wrong++;
+        if (dif > res.maxulp) {
+            res.maxulp = dif;  res.worst = uint16_t(i);
+            res.worstResult = r;  res.worstExpected = e;
+        }
+    }
+}
+
+// print one line of ULP table. Returns 1 if error is above limit
+int ulpPrint(UlpFunction const& f, const char * vname, UlpResult const& res) {
+    printf("\n%-5i %-6s %-7s %7i %6i %7i %5i", f.tcase, f.name, vname, res.maxulp, f.limit, res.wrong, res.nanerrors);
+    if (res.maxulp > 0) {
+        printf("   0x%04X %10.5G -> %10.5G != %10.5G", res.worst, to_float(res.worst), 
+            to_float(res.worstResult), to_float(res.worstExpected));
+    }
+    bool fail = res.maxulp > f.limit || res.nanerrors > 0;
+    if (fail) printf("  error");
+    return fail;
+}
+
+// make ULP table of all functions with all inputs and all vector sizes. Returns number of errors
+int ulpTable() {
+    int numerrors = 0;
+    auto time0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 0x10000; i++) ulpInput[i] = half2fp16(uint16_t(i));
+    to_float_block(ulpInput, ulpInputFloat, 0x10000);
+    printf("\nULP table of half precision mathematical functions, all inputs, instruction set %i, %s half precision",
+        INSTRSET, ulpNative ? "native" : "emulated");
+    printf("\nwrong = not correctly rounded. nan = NAN mismatch. Worst input: input -> result != expected\n");
+    printf("\n%-5s %-6s %-7s %7s %6s %7s %5s   %s", "case", "func", "vector", "max ULP", "limit", "wrong", "nan", "worst input");
+    for (UlpFunction const& f : ulpFunctions) {
+        for (int i = 0; i < 0x10000; i++) ulpExpectedFloat[i] = ulpReference(f.tcase, ulpInputFloat[i]);
+        to_float16_block(ulpExpectedFloat, ulpExpected, 0x10000);
+        UlpResult r8, r16, r32;
+        ulpRun<Vec8h>(f, r8);
+        ulpRun<Vec16h>(f, r16);
+        ulpRun<Vec32h>(f, r32);
+        numerrors += ulpPrint(f, "Vec8h", r8);
+        numerrors += ulpPrint(f, "Vec16h", r16);
+        numerrors += ulpPrint(f, "Vec32h", r32);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time0).count();
+    printf("\n\n%i functions tested in %.2f seconds", int(sizeof(ulpFunctions) / sizeof(ulpFunctions[0])), seconds);
+    if (numerrors) printf("\n%i errors above limit", numerrors);
+    return numerrors;
+}
+#endif  // ULP_TABLE
+
+#ifdef BENCHMARK
+// ----------------------------------------------------------------------------
+//         Benchmark of test function
+// ----------------------------------------------------------------------------
+#ifndef BENCHFILE
+#define BENCHFILE "bench4.csv"    // file for benchmark results
+#endif
+#ifndef BENCHREPEAT
+#define BENCHREPEAT 20            // number of repetitions. The fastest is used
+#endif
+#ifdef __AVX512FP16__
+const int nativeFP16 = 1;         // half precision instructions are used
+#else
+const int nativeFP16 = 0;         // half precision is emulated with float instructions
+#endif
+#ifdef EMULATED
+const int emulated = 1;           // running in emulator. Clock counts are not valid
+#else
+const int emulated = 0;
+#endif
+
+// read time stamp counter
+static inline uint64_t readTSC() {
+    return __rdtsc();
+}
+
+RT benchResult[TestData<ST>::listsize + maxvectorsize]; // results of benchmark
+uint64_t benchBits = 0;           // results of benchmark with boolean vectors
+volatile uint64_t benchSink;      // prevent optimizing away the results
+
+// store result of benchmark
+template <typename V>
+inline void benchStore(V const & r, int j) {
+    if constexpr (V::elementtype() < 4) {        // boolean vector
+        benchBits ^= to_bits(r);
+    }
+    else {
+        r.store(benchResult + j);
+    }
+}
+
+// measure clock cycles per element for test function over the same
+// combinations of test data as in the test. Print result and append it to BENCHFILE
+void benchmark(const ST * alist, int asize, const ST * blist, int bsize) {
+    constexpr int vectorsize = vtype::size();
+    vtype a, b;
+#if defined(USE_FLAG)
+    vtype f(ST(0));
+    for (int k = 0; k < vectorsize; k++) {
+        f.insert(k, ST(k%3 != 0));
+    }
+#endif
+    uint64_t bestTime = ~uint64_t(0);
+    int i, j, r;
+    for (r = 0; r < BENCHREPEAT; r++) {
+        uint64_t time0 = readTSC();
+        for (i = 0; i < asize; i += vectorsize) {
+            loadData(a, alist + i);
+            for (j = 0; j < bsize; j += vectorsize) {
+                loadData(b, blist + j);
+#if defined(USE_FLAG)
+                benchStore(testFunction(f, a, b), j);
+#else
+                benchStore(testFunction(a, b), j);
+#endif
+            }
+        }
+        uint64_t time1 = readTSC();
+        if (time1 - time0 < bestTime) bestTime = time1 - time0;
+    }
+    benchSink = benchBits;
+    uint64_t numElements = uint64_t(asize / vectorsize) * bsize;
+    double clocks = double(bestTime) / double(numElements);
+    printf("\nBenchmark of test case %i, %s -> %s, instruction set %i, %s half precision:", 
+        testcase, TOSTRING(vtype), TOSTRING(rtype), INSTRSET, nativeFP16 ? "native" : "emulated");
+    printf("\n  %.3f clock cycles per element", clocks);
+    if (emulated) printf("\n  running in emulator. Clock counts are not valid");
+    FILE * ff = fopen(BENCHFILE, "a");
+    if (ff == 0) {
+        printf("\nCannot write file %s", BENCHFILE);
+        return;
+    }
+    fseek(ff, 0, SEEK_END);
+    if (ftell(ff) == 0) {                        // new file. Write header
+        fprintf(ff, "testcase,vtype,rtype,INSTRSET,native_fp16,clocks,emulated\n");
+    }
+    fprintf(ff, "%i,%s,%s,%i,%i,%.4f,%i\n", testcase, TOSTRING(vtype), TOSTRING(rtype), INSTRSET, 
+        nativeFP16, clocks, emulated);
+    fclose(ff);
+}
+#endif  // BENCHMARK
+
+#ifdef CONVERSION_BENCHMARK
+// ----------------------------------------------------------------------------
+//         Benchmark of conversion of big arrays Float16 <-> float
+// ----------------------------------------------------------------------------
+#if defined(EXHAUSTIVE_PAIRS) || defined(ULP_TABLE) || defined(BENCHMARK)
+#error CONVERSION_BENCHMARK cannot be combined with EXHAUSTIVE_PAIRS, ULP_TABLE, or BENCHMARK
+#endif
+#ifndef CONVERSION_MAXSIZE
+#define CONVERSION_MAXSIZE (1 << 24)       // max number of elements in array
+#endif
+#ifndef CONVERSION_FILE
+#define CONVERSION_FILE "conv4.csv"        // file for benchmark results
+#endif
+#ifndef CONVERSION_TRAFFIC
+#define CONVERSION_TRAFFIC (1 << 26)       // minimum number of elements converted in each measurement
+#endif
+static_assert(CONVERSION_MAXSIZE >= 0x1000 && (CONVERSION_MAXSIZE & 0xF) == 0,
+    "CONVERSION_MAXSIZE must be a multiple of 16 and at least 4096");
+
+#ifdef EMULATED
+const int convEmulated = 1;       // running in emulator. Clock counts are not valid
+#else
+const int convEmulated = 0;
+#endif
+
+// convert n half precision numbers to float with Vec16h -> Vec16f.
+// aligned: src and dst are aligned by 64 and n is a multiple of 16. 
+// Otherwise, the last partial vector is converted with load_partial and store_partial
+template <bool aligned>
+void convertToFloat(Float16 const * src, float * dst, int n) {
+    Vec16h h;
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        if constexpr (aligned) {
+            h.load_a(src + i);
+            to_float(h).store_a(dst + i);
+        }
+        else {
+            h.load(src + i);
+            to_float(h).store(dst + i);
+        }
+    }
+    if (!aligned && i < n) {                     // tail
+        h.load_partial(n - i, src + i);
+        to_float(h).store_partial(n - i, dst + i);
+    }
+}
+
+// convert n float numbers to half precision with Vec16f -> Vec16h
+template <bool aligned>
+void convertToHalf(float const * src, Float16 * dst, int n) {
+    Vec16f f;
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        if constexpr (aligned) {
+            f.load_a(src + i);
+            to_float16(f).store_a(dst + i);
+        }
+        else {
+            f.load(src + i);
+            to_float16(f).store(dst + i);
+        }
+    }
+    if (!aligned && i < n) {                     // tail
+        f.load_partial(n - i, src + i);
+        to_float16(f).store_partial(n - i, dst + i);
+    }
+}
+
+// allocate memory aligned by 64
+void * alignedAlloc(size_t size, void ** block) {
+    *block = malloc(size + 64);
+    if (*block == 0) {
+        printf("\nMemory allocation failed");
+        exit(1);
+    }
+    return (void *)(((size_t)*block + 63) & ~size_t(63));
+}
+
+// measure one conversion for one array size. Returns number of errors in the results
+template <bool toFloat, bool aligned>
+int conversionRun(Float16 * hbuf, float * fbuf, int n, FILE * ff) {
+    Float16 const * hsrc = hbuf;  float const * fsrc = fbuf;
+    static float fcheck[16];  static uint16_t hcheck[16];
+    int reps = CONVERSION_TRAFFIC / n;           // repetitions in each measurement
+    if (reps < 1) reps = 1;
+    uint64_t bestClocks = ~uint64_t(0);
+    double bestSeconds = 1.E99;
+    for (int r = 0; r < 5; r++) {                // use the fastest of 5 measurements
+        auto time0 = std::chrono::steady_clock::now();
+        uint64_t clock0 = __rdtsc();
+        for (int k = 0; k < reps; k++) {
+            if constexpr (toFloat) convertToFloat<aligned>(hsrc, fbuf, n);
+            else convertToHalf<aligned>(fsrc, hbuf, n);
+        }
+        uint64_t clock1 = __rdtsc();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time0).count();
+        if (clock1 - clock0 < bestClocks) bestClocks = clock1 - clock0;
+        if (seconds < bestSeconds) bestSeconds = seconds;
+    }
+    // check results at the start and the tail of the array
+    int errors = 0;
+    for (int j = 0; j < n; j++) {
+        if (j == 16 && n > 32) j = n - 16;      // skip to last 16 elements
+        if constexpr (toFloat) {
+            to_float_block(hsrc + j, fcheck, 1);
+            if (!(fbuf[j] == fcheck[0])) errors++;
+        }
+        else {
+            to_float16_block(fsrc + j, hcheck, 1);
+            if (fp162half(hbuf[j]) != hcheck[0]) errors++;
+        }
+    }
+    double elements = double(n) * reps;
+    double bytes = elements * (sizeof(Float16) + sizeof(float));  // read + write
+    double gbs = bytes / bestSeconds * 1.E-9;
+    double perClock = elements / double(bestClocks);
+    const char * name = toFloat ? "Vec16h->Vec16f" : "Vec16f->Vec16h";
+    const char * tail = aligned ? "aligned" : "unaligned";
+    printf("\n%-15s %-10s %10i %12.1f %10.2f %10.3f", name, tail, n, 
+        double(n) * (sizeof(Float16) + sizeof(float)) / 1024., gbs, perClock);
+    if (errors) printf("  %i errors", errors);
+    if (ff) {
+        fprintf(ff, "%i,%s,%s,%i,%.0f,%.3f,%.4f,%i\n", INSTRSET, name, tail, n, 
+            double(n) * (sizeof(Float16) + sizeof(float)), gbs, perClock, convEmulated);
+    }
+    return errors;
+}
+
+// measure conversion throughput for array sizes from L1 cache size to CONVERSION_MAXSIZE.
+// Returns number of errors
+int conversionBenchmark() {
+    void * hblock, * fblock;
+    // one extra vector for unaligned start
+    Float16 * hbuf = (Float16 *)alignedAlloc((CONVERSION_MAXSIZE + 16) * sizeof(Float16), &hblock);
+    float * fbuf = (float *)alignedAlloc((CONVERSION_MAXSIZE + 16) * sizeof(float), &fblock);
+    // fill buffers with random numbers in the half precision range, without NAN
+    ranGen rangen(seed);
+    for (int i = 0; i < CONVERSION_MAXSIZE + 16; i++) {
+        uint16_t h = uint16_t(rangen.next());
+        if ((h & 0x7C00) == 0x7C00) h &= 0xBFFF;    // avoid INF and NAN
+        hbuf[i] = half2fp16(h);
+    }
+    to_float_block(hbuf, fbuf, CONVERSION_MAXSIZE + 16);
+    FILE * ff = fopen(CONVERSION_FILE, "a");
+    if (ff == 0) {
+        printf("\nCannot write file %s", CONVERSION_FILE);
+    }
+    else {
+        fseek(ff, 0, SEEK_END);
+        if (ftell(ff) == 0) {                    // new file. Write header
+            fprintf(ff, "INSTRSET,conversion,layout,elements,bytes,GBs,elements_per_clock,emulated\n");
+        }
+    }
+    printf("\nThroughput of conversion of arrays, instruction set %i", INSTRSET);
+    printf("\nunaligned: arrays start one element after a 64 bytes boundary and end with a partial vector");
+    printf("\nGB/s counts bytes read and written. Clock = time stamp counter clock");
+    if (convEmulated) printf("\nRunning in emulator. Speed is not valid");
+    printf("\n\n%-15s %-10s %10s %12s %10s %10s", "conversion", "layout", "elements", "kbytes", "GB/s", "elem/clock");
+    int errors = 0;
+    for (int n = 0x1000; n <= CONVERSION_MAXSIZE; n *= 4) {
+        errors += conversionRun<true, true>(hbuf, fbuf, n, ff);
+        errors += conversionRun<true, false>(hbuf + 1, fbuf + 1, n - 7, ff);
+        errors += conversionRun<false, true>(hbuf, fbuf, n, ff);
+        errors += conversionRun<false, false>(hbuf + 1, fbuf + 1, n - 7, ff);
+    }
+    if (ff) fclose(ff);
+    free(hblock);  free(fblock);
+    return errors;
+}
+#endif  // CONVERSION_BENCHMARK
+
+#ifdef SUM_TEST
+// ----------------------------------------------------------------------------
+//         Accuracy and speed of different methods for summing long arrays
+// ----------------------------------------------------------------------------
+#if defined(EXHAUSTIVE_PAIRS) || defined(ULP_TABLE) || defined(BENCHMARK) || defined(CONVERSION_BENCHMARK)
+#error SUM_TEST cannot be combined with other test modes
+#endif
+#ifndef SUM_MAXSIZE
+#define SUM_MAXSIZE (1 << 22)             // max number of elements in array
+#endif
+#ifndef SUM_FILE
+#define SUM_FILE "sum4.csv"               // file for results
+#endif
+static_assert(SUM_MAXSIZE >= 1024 && (SUM_MAXSIZE & (SUM_MAXSIZE - 1)) == 0, 
+    "SUM_MAXSIZE must be a power of 2 >= 1024");
+
+#ifdef EMULATED
+const int sumEmulated = 1;        // running in emulator. Clock counts are not valid
+#else
+const int sumEmulated = 0;
+#endif
+
+// summation methods
+enum SumMethod {
+    SUM_HADD,                     // horizontal_add of each vector, accumulated in a half precision scalar
+    SUM_VECTOR,                   // accumulate in a half precision vector, horizontal_add at the end
+    SUM_PAIRWISE,                 // pairwise tree of half precision vectors
+    SUM_HADD_X,                   // horizontal_add_x of each vector, accumulated in a float scalar
+    SUM_FLOAT,                    // convert to float vectors and accumulate, horizontal_add at the end
+    SUM_NUMMETHODS
+};
+const char * sumMethodNames[SUM_NUMMETHODS] = {"hadd", "vector", "pairwise", "hadd_x", "float"};
+volatile float sumSink;           // prevent optimizing away the results
+
+// pairwise summation of n elements. n must be a multiple of the vector size.
+// Blocks of up to 8 vectors are summed in a vector accumulator
+template <typename V>
+V sumPairwise(Float16 const * p, int n) {
+    if (n <= 8 * V::size()) {
+        V acc(0), x;
+        for (int i = 0; i < n; i += V::size()) {
+            acc += x.load(p + i);
+        }
+        return acc;
+    }
+    int half = n / 2 / V::size() * V::size();
+    return sumPairwise<V>(p, half) + sumPairwise<V>(p + half, n - half);
+}
+
+// sum n elements with method m and vector type V. Result is rounded to half precision
+template <typename V>
+float sumArray(SumMethod m, Float16 const * p, int n) {
+    constexpr int vs = V::size();
+    V x;
+    int i;
+    switch (m) {
+    case SUM_HADD: {
+        Float16 s = Float16(0);
+        for (i = 0; i < n; i += vs) s = s + horizontal_add(x.load(p + i));
+        return float(s);}
+    case SUM_VECTOR: {
+        V acc(0);
+        for (i = 0; i < n; i += vs) acc += x.load(p + i);
+        return float(horizontal_add(acc));}
+    case SUM_PAIRWISE:
+        return float(horizontal_add(sumPairwise<V>(p, n)));
+    case SUM_HADD_X: {
+        float s = 0.f;
+        for (i = 0; i < n; i += vs) s += horizontal_add_x(x.load(p + i));
+        return float(Float16(s));}
+    case SUM_FLOAT: 
+        if constexpr (vs == 8) {
+            Vec8f acc(0.f);
+            for (i = 0; i < n; i += vs) acc += to_float(x.load(p + i));
+            return float(Float16(horizontal_add(acc)));
+        }
+        else {
+            Vec16f acc(0.f);
+            for (i = 0; i < n; i += vs) {
+                x.load(p + i);
+                if constexpr (vs == 16) acc += to_float(x);
+                else acc += to_float(x.get_low()) + to_float(x.get_high());
+            }
+            return float(Float16(horizontal_add(acc)));
+        }
+    default:;
+    }
+    return 0.f;
+}
+
+// exact sum of n half precision numbers. All half precision numbers are integer
+// multiples of 2^-24, so the sum can be calculated exactly with 64-bit integers
+double sumExact(float const * f, int n) {
+    int64_t s = 0;
+    for (int i = 0; i < n; i++) s += (int64_t)(double(f[i]) * 16777216.);
+    return double(s) * (1. / 16777216.);
+}
+
+// unit in the last place of a half precision number of size x
+double halfUlp(double x) {
+    int e;
+    frexp(x, &e);
+    if (e < -13) e = -13;                        // subnormal
+    return ldexp(1., e - 11);
+}
+
+// test all methods with vector type V and one array. Print results
+template <typename V>
+void sumRun(const char * vname, const char * dataname, Float16 const * p, float const * f, int n, FILE * ff) {
+    double exact = sumExact(f, n);
+    int reps = (1 << 24) / n;                    // repetitions for time measurement
+    for (int m = 0; m < SUM_NUMMETHODS; m++) {
+        float s = sumArray<V>(SumMethod(m), p, n);
+        uint64_t bestClocks = ~uint64_t(0);
+        for (int r = 0; r < 5; r++) {            // use the fastest of 5 measurements
+            float sink = 0.f;
+            uint64_t clock0 = __rdtsc();
+            for (int k = 0; k < reps; k++) sink += sumArray<V>(SumMethod(m), p, n);
+            uint64_t clock1 = __rdtsc();
+            sumSink = sink;
+            if (clock1 - clock0 < bestClocks) bestClocks = clock1 - clock0;
+        }
+        double clocks = double(bestClocks) / (double(n) * reps);
+        double relerr = std::fabs(s - exact) / std::fabs(exact);
+        double ulp = std::fabs(s - exact) / halfUlp(exact);
+        printf("\n%-7s %-9s %9i %-9s %14.6G %14.6G %10.3G %9.1f %10.3f", vname, dataname, n, 
+            sumMethodNames[m], exact, s, relerr, ulp, clocks);
+        if (ff) {
+            fprintf(ff, "%i,%s,%s,%i,%s,%.8G,%.8G,%.4G,%.2f,%.4f,%i\n", INSTRSET, vname, dataname, n, 
+                sumMethodNames[m], exact, s, relerr, ulp, clocks, sumEmulated);
+        }
+    }
+}
+
+// test all methods, vector types, and array sizes with two sets of data:
+// positive: uniform random in [0, 1) * scale. The scale is 2000 / n.
+// mixed: uniform random in [-0.5, 1) * scale, with cancellation. The scale is 4000 / n.
+// The mean is 0.5 * scale or 0.25 * scale, so the sum is near 1000 in both cases
+int sumTest() {
+    Float16 * hbuf = new Float16[SUM_MAXSIZE];
+    float * fbuf = new float[SUM_MAXSIZE];
+    FILE * ff = fopen(SUM_FILE, "a");
+    if (ff == 0) {
+        printf("\nCannot write file %s", SUM_FILE);
+    }
+    else {
+        fseek(ff, 0, SEEK_END);
+        if (ftell(ff) == 0) {                    // new file. Write header
+            fprintf(ff, "INSTRSET,vtype,data,elements,method,exact,sum,relative_error,ULP,clocks,emulated\n");
+        }
+    }
+    printf("\nAccuracy and speed of summation of half precision arrays, instruction set %i", INSTRSET);
+    printf("\nThe sum is rounded to half precision. Error is relative to the exact sum");
+    printf("\nMethods:\n  hadd:     horizontal_add of each vector, accumulated in half precision scalar");
+    printf("\n  vector:   accumulate in half precision vector, horizontal_add at the end");
+    printf("\n  pairwise: pairwise tree of half precision vectors");
+    printf("\n  hadd_x:   horizontal_add_x of each vector, accumulated in float scalar");
+    printf("\n  float:    convert to float vectors and accumulate");
+    if (sumEmulated) printf("\nRunning in emulator. Clock counts are not valid");
+    printf("\n\n%-7s %-9s %9s %-9s %14s %14s %10s %9s %10s", 
+        "vector", "data", "elements", "method", "exact", "sum", "rel.error", "ULP", "clock/elem");
+    ranGen rangen(seed);
+    for (int d = 0; d < 2; d++) {
+        const char * dataname = d ? "mixed" : "positive";
+        for (int n = 1024; n <= SUM_MAXSIZE; n *= 16) {
+            float scale = (d ? 4000.f : 2000.f) / n;
+            for (int i = 0; i < n; i++) {
+                float u = get_random<float>(rangen);
+                fbuf[i] = (d ? u * 1.5f - 0.5f : u) * scale;
+            }
+            to_float16_block(fbuf, hbuf, n);     // round to half precision
+            to_float_block(hbuf, fbuf, n);       // exact values of half precision numbers
+            sumRun<Vec8h>("Vec8h", dataname, hbuf, fbuf, n, ff);
+            sumRun<Vec16h>("Vec16h", dataname, hbuf, fbuf, n, ff);
+            sumRun<Vec32h>("Vec32h", dataname, hbuf, fbuf, n, ff);
+        }
+    }
+    if (ff) fclose(ff);
+    delete[] hbuf;  delete[] fbuf;
+    return 0;
+}
+#endif  // SUM_TEST
+
+#ifdef MASK_TEST
+// ----------------------------------------------------------------------------
+//         Exhaustive test of boolean results, compared as bit masks
+// ----------------------------------------------------------------------------
+#if defined(EXHAUSTIVE_PAIRS) || defined(ULP_TABLE) || defined(BENCHMARK) || defined(CONVERSION_BENCHMARK) || defined(SUM_TEST)
+#error MASK_TEST cannot be combined with other test modes
+#endif
+#ifndef MASK_ROWS
+#define MASK_ROWS 0x10000     // number of values of the first operand in comparisons
+#endif
+static_assert(MASK_ROWS > 0 && MASK_ROWS <= 0x10000 && (0x10000 % MASK_ROWS) == 0, 
+    "MASK_ROWS must be a power of 2 <= 65536");
+
+typedef decltype(vtype() < vtype()) btype;       // boolean vector type
+const bool maskCompact = btype::elementtype() == 2; // boolean vector is a compact bit mask
+
+Float16 maskHalves[0x10000 + maxvectorsize];     // all half precision bit patterns
+int16_t maskKey[0x10000 + maxvectorsize];        // order of half precision values. Same for +0 and -0
+bool maskNan[0x10000 + maxvectorsize];           // half precision value is NAN
+std::atomic<int> nextMaskRow(0);                 // next row of work
+std::mutex maskMutex;                            // prevent threads from printing at the same time
+std::atomic<uint64_t> maskErrors(0);             // number of wrong elements
+std::atomic<int> maskReported(0);                // number of wrong elements reported
+
+const int maskNumClassify = 6;                   // number of classification functions
+const char * maskClassifyNames[maskNumClassify] = {
+    "is_finite", "is_inf", "is_nan", "is_subnormal", "is_zero_or_subnormal", "sign_bit"};
+const int maskNumCompare = 6;                    // number of comparison operators
+const char * maskCompareNames[maskNumCompare] = {"<", "<=", "==", "!=", ">=", ">"};
+
+// classification function under test, as bit mask
+inline uint64_t maskClassify(int f, vtype const& x) {
+    switch (f) {
+    case 0: return uint64_t(to_bits(is_finite(x)));
+    case 1: return uint64_t(to_bits(is_inf(x)));
+    case 2: return uint64_t(to_bits(is_nan(x)));
+    case 3: return uint64_t(to_bits(is_subnormal(x)));
+    case 4: return uint64_t(to_bits(is_zero_or_subnormal(x)));
+    case 5: return uint64_t(to_bits(sign_bit(x)));
+    }
+    return 0;
+}
+
+// reference for classification function
+inline bool maskClassifyReference(int f, uint16_t h) {
+    switch (f) {
+    case 0: return (h & 0x7C00) != 0x7C00;
+    case 1: return (h & 0x7FFF) == 0x7C00;
+    case 2: return (h & 0x7FFF) > 0x7C00;
+    case 3: return (h & 0x7C00) == 0 && (h & 0x03FF) != 0;
+    case 4: return (h & 0x7C00) == 0;
+    case 5: return (h & 0x8000) != 0;
+    }
+    return false;
+}
+
+// comparison operator under test, as bit mask
+inline uint64_t maskCompare(int f, vtype const& a, vtype const& b) {
+    switch (f) {
+    case 0: return uint64_t(to_bits(a < b));
+    case 1: return uint64_t(to_bits(a <= b));
+    case 2: return uint64_t(to_bits(a == b));
+    case 3: return uint64_t(to_bits(a != b));
+    case 4: return uint64_t(to_bits(a >= b));
+    case 5: return uint64_t(to_bits(a > b));
+    }
+    return 0;
+}
+
+// reference for comparison operator. All comparisons are false for NAN, except !=
+inline bool maskCompareReference(int f, int i, int j) {
+    if (maskNan[i] || maskNan[j]) return f == 3;
+    int a = maskKey[i], b = maskKey[j];
+    switch (f) {
+    case 0: return a < b;
+    case 1: return a <= b;
+    case 2: return a == b;
+    case 3: return a != b;
+    case 4: return a >= b;
+    case 5: return a > b;
+    }
+    return false;
+}
+
+// report elements that differ between result mask r and expected mask e
+void maskErrorReport(const char * name, Float16 const * a, Float16 const * b, uint64_t r, uint64_t e) {
+    uint64_t dif = r ^ e;
+    uint64_t n = 0;                              // number of wrong elements
+    for (uint64_t d = dif; d; d &= d - 1) n++;
+    maskErrors.fetch_add(n);
+    for (int k = 0; k < vtype::size(); k++) {
+        if (!(dif >> k & 1)) continue;
+        if (maskReported >= maxerrors) return;   // check first to avoid overflow of counter
+        int m = maskReported++;
+        if (m >= maxerrors) return;              // lock only for the errors printed
+        std::lock_guard<std::mutex> lock(maskMutex);
+        if (m == 0) printf("\nMask test:");
+        printf("\nError in %s element %i: ", name, k);
+        printf("0x%04X ", fp162half(a[k]));
+        if (b) printf("0x%04X ", fp162half(b[k]));
+        printf("-> %i != %i", int(r >> k & 1), int(e >> k & 1));
+    }
+}
+
+// test all classification functions with all inputs
+void maskClassifyTest() {
+    constexpr int vs = vtype::size();
+    vtype x;
+    for (int f = 0; f < maskNumClassify; f++) {
+        for (int i = 0; i < 0x10000; i += vs) {
+            x.load(maskHalves + i);
+            uint64_t r = maskClassify(f, x);
+            uint64_t e = 0;
+            for (int k = 0; k < vs; k++) {
+                e |= uint64_t(maskClassifyReference(f, uint16_t(i + k))) << k;
+            }
+            if (r != e) maskErrorReport(maskClassifyNames[f], maskHalves + i, 0, r, e);
+        }
+    }
+}
+
+// test rows of pairs with all comparison operators until all rows are done.
+// Row n has the first operand a = n + k in vector element k, and the second operand 
+// runs through all 65536 values
+void maskCompareThread() {
+    constexpr int vs = vtype::size();
+    vtype a, b;
+    Float16 alist[vs];
+    int aindex[vs];
+    const int rowstep = 0x10000 / MASK_ROWS;     // step between rows tested
+    while (true) {
+        int row = nextMaskRow++;                 // get next row of work
+        if (row >= MASK_ROWS) break;             // finished
+        int first = row * rowstep;
+        for (int k = 0; k < vs; k++) {
+            aindex[k] = (first + k) & 0xFFFF;
+            alist[k] = maskHalves[aindex[k]];
+        }
+        a.load(alist);
+        for (int j = 0; j < 0x10000; j += vs) {
+            b.load(maskHalves + j);
+            for (int f = 0; f < maskNumCompare; f++) {
+                uint64_t r = maskCompare(f, a, b);
+                uint64_t e = 0;
+                for (int k = 0; k < vs; k++) {
+                    e |= uint64_t(maskCompareReference(f, aindex[k], j + k)) << k;
+                }
+                if (r != e) maskErrorReport(maskCompareNames[f], alist, maskHalves + j, r, e);
+            }
+        }
+    }
+}
+
+volatile uint64_t maskSink;       // prevent optimizing away the results
+
+// measure clock cycles per vector for making a mask and using it as bits or in select
+void maskBenchmark() {
+    constexpr int vs = vtype::size();
+    const int reps = 50;
+    vtype x, b(ST(1.f)), acc;
+    uint64_t bits;
+    printf("\n\nSpeed of functions with boolean result, %s, instruction set %i, %s boolean vectors:", 
+        TOSTRING(vtype), INSTRSET, maskCompact ? "compact" : "broadcast");
+    printf("\n%-22s %12s %12s", "function", "to_bits", "select");
+    for (int f = 0; f < maskNumClassify + maskNumCompare; f++) {
+        uint64_t best[2] = {~uint64_t(0), ~uint64_t(0)};
+        for (int r = 0; r < reps; r++) {
+            // use result as bit mask
+            bits = 0;
+            uint64_t time0 = __rdtsc();
+            for (int i = 0; i < 0x10000; i += vs) {
+                x.load(maskHalves + i);
+                bits += f < maskNumClassify ? maskClassify(f, x) : maskCompare(f - maskNumClassify, x, b);
+            }
+            uint64_t time1 = __rdtsc();
+            maskSink = bits;
+            if (time1 - time0 < best[0]) best[0] = time1 - time0;
+            // use result as boolean vector in select
+            acc = vtype(ST(0.f));
+            time0 = __rdtsc();
+            for (int i = 0; i < 0x10000; i += vs) {
+                x.load(maskHalves + i);
+                switch (f) {
+                case 0: acc = select(is_finite(x), acc, x);  break;
+                case 1: acc = select(is_inf(x), acc, x);  break;
+                case 2: acc = select(is_nan(x), acc, x);  break;
+                case 3: acc = select(is_subnormal(x), acc, x);  break;
+                case 4: acc = select(is_zero_or_subnormal(x), acc, x);  break;
+                case 5: acc = select(sign_bit(x), acc, x);  break;
+                case 6: acc = select(x < b, acc, x);  break;
+                case 7: acc = select(x <= b, acc, x);  break;
+                case 8: acc = select(x == b, acc, x);  break;
+                case 9: acc = select(x != b, acc, x);  break;
+                case 10: acc = select(x >= b, acc, x);  break;
+                case 11: acc = select(x > b, acc, x);  break;
+                }
+            }
+            time1 = __rdtsc();
+            maskSink = fp162half(acc[0]);
+            if (time1 - time0 < best[1]) best[1] = time1 - time0;
+        }
+        const char * name = f < maskNumClassify ? maskClassifyNames[f] : maskCompareNames[f - maskNumClassify];
+        printf("\n%-22s %12.3f %12.3f", name, double(best[0]) * vs / 0x10000, double(best[1]) * vs / 0x10000);
+    }
+    printf("\nClock cycles per vector");
+#ifdef EMULATED
+    printf("\nRunning in emulator. Clock counts are not valid");
+#endif
+}
+
+// test classification functions with all inputs and comparisons with all pairs of inputs.
+// The work is distributed between nthreads threads. Returns number of wrong elements
+uint64_t maskTest(int nthreads) {
+    if (nthreads <= 0) nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0) nthreads = 1;
+    for (int i = 0; i < 0x10000 + maxvectorsize; i++) {
+        uint16_t h = uint16_t(i);
+        maskHalves[i] = half2fp16(h);
+        maskKey[i] = (h & 0x8000) ? -int16_t(h & 0x7FFF) : int16_t(h & 0x7FFF);
+        maskNan[i] = (h & 0x7FFF) > 0x7C00;
+    }
+    auto time0 = std::chrono::steady_clock::now();
+    maskClassifyTest();
+    std::thread * threads = new std::thread[nthreads];
+    int t;
+    for (t = 0; t < nthreads; t++) threads[t] = std::thread(maskCompareThread);
+    for (t = 0; t < nthreads; t++) threads[t].join();
+    delete[] threads;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time0).count();
+    printf("\nMask test of %s: %i classification functions with 65536 inputs, %i comparisons with %llu pairs",
+        TOSTRING(vtype), maskNumClassify, maskNumCompare, (unsigned long long)MASK_ROWS * 0x10000);
+    printf("\n%.1f seconds, %i threads", seconds, nthreads);
+    printf("\n%llu errors", (unsigned long long)maskErrors);
+    maskBenchmark();
+    return maskErrors;
+}
+#endif  // MASK_TEST
+
+#ifdef FMA_TEST
+// ----------------------------------------------------------------------------
+//         Test of rounding of fused multiply and add near rounding boundaries
+// ----------------------------------------------------------------------------
+#if defined(EXHAUSTIVE_PAIRS) || defined(ULP_TABLE) || defined(BENCHMARK) || defined(CONVERSION_BENCHMARK) || defined(SUM_TEST) || defined(MASK_TEST)
+#error FMA_TEST cannot be combined with other test modes
+#endif
+#ifndef FMA_TRIPLES
+#define FMA_TRIPLES (1 << 30)     // number of triples tested for each function
+#endif
+const int fmaBlock = 0x10000;     // number of triples in each block of work
+static_assert(FMA_TRIPLES >= fmaBlock && FMA_TRIPLES % fmaBlock == 0, 
+    "FMA_TRIPLES must be a multiple of 65536");
+
+const int fmaNumFunctions = 3;
+const char * fmaNames[fmaNumFunctions] = {"mul_add", "mul_sub", "nmul_add"};
+
+// fused function under test
+inline vtype fmaFunction(int f, vtype const& a, vtype const& b, vtype const& c) {
+    switch (f) {
+    case 0: return mul_add(a, b, c);
+    case 1: return mul_sub(a, b, c);
+    case 2: return nmul_add(a, b, c);
+    }
+    return a;
+}
+
+// round double to half precision with a single rounding. Round to nearest or even
+uint16_t roundToHalf(double x) {
+    uint16_t sign = x < 0. ? 0x8000 : 0;
+    x = std::fabs(x);
+    if (x == 0.) return sign;
+    int e;
+    frexp(x, &e);                                // x = m * 2^e, 0.5 <= m < 1
+    int qe = e - 11;                             // exponent of unit in last place
+    if (qe < -24) qe = -24;                      // subnormal
+    double r = ldexp(nearbyint(ldexp(x, -qe)), qe); // nearbyint rounds ties to even
+    if (r > 65504.) return sign | 0x7C00;        // overflow to INF
+    return sign | to_float16(float(r));          // r is exactly representable
+}
+
+// check if x is exactly halfway between two adjacent half precision numbers
+bool isHalfMidpoint(double x) {
+    x = std::fabs(x);
+    if (x == 0.) return false;
+    int e;
+    frexp(x, &e);
+    int qe = e - 11;                             // exponent of unit in last place
+    if (qe < -24) qe = -24;                      // subnormal
+    double h = ldexp(x, 1 - qe);                 // x in units of half ULP
+    return h == nearbyint(h) && std::fmod(h, 2.) != 0.; // odd number of half ULPs
+}
+
+// make triples a, b, c where a*b is just below a power of two, 2^e*(1 - x^2*2^-20),
+// with a = 2^ea*(1 + x*2^-10) and b = 2^eb*(1 - x*2^-10). c is a half precision number
+// with unit in last place 2^(e+1), so that a*b + c is close to the midpoint between two
+// half precision numbers. For x < 12, a*b + c rounded to float is exactly the midpoint,
+// so that a calculation via float is rounded twice. x = 0 gives an exact midpoint, except
+// when c is a power of two and a*b has the opposite sign, because c - 2^e is representable.
+// Bigger x are controls without double rounding
+void fmaTriples(int block, Float16 * a, Float16 * b, Float16 * c, uint8_t * xlist) {
+    ranGen rangen(seed + block);
+    for (int i = 0; i < fmaBlock; i++) {
+        uint32_t r1 = rangen.next(), r2 = rangen.next();
+        int x = r1 & 15;
+        if (x >= 12) x = 12 + (r1 >> 4 & 31);
+        int e = -25 + int((r1 >> 9) % 30);      // exponent of product: -25 <= e <= 4
+        int lo = e - 15 > -14 ? e - 15 : -14;
+        int hi = e + 14 < 15 ? e + 14 : 15;
+        int ea = lo + int((r1 >> 14) % (hi - lo + 1));
+        int eb = e - ea;
+        float af = ldexpf(1.f + x / 1024.f, ea);
+        float bf = ldexpf(1.f - x / 1024.f, eb);
+        float cf = ldexpf(float(1024 + (r2 & 1023)), e + 1);
+        if (r2 & 0x400) af = -af;
+        if (r2 & 0x800) bf = -bf;
+        if (r2 & 0x1000) cf = -cf;
+        if (r2 & 0x2000) {                       // swap a and b
+            float t = af;  af = bf;  bf = t;
+        }
+        a[i] = half2fp16(to_float16(af));
+        b[i] = half2fp16(to_float16(bf));
+        c[i] = half2fp16(to_float16(cf));
+        xlist[i] = uint8_t(x);
+    }
+}
+
+// results from one thread
+struct FmaResult {
+    uint64_t count[fmaNumFunctions] = {0};      // number of triples tested
+    uint64_t wrong[fmaNumFunctions] = {0};      // results not correctly rounded
+    uint64_t twice[fmaNumFunctions] = {0};      // wrong results equal to rounding via float
+    uint64_t ties[fmaNumFunctions] = {0};       // number of exact midpoints tested
+    uint64_t tieswrong[fmaNumFunctions] = {0};  // exact midpoints not rounded to even
+};
+
+std::atomic<int> nextFmaBlock(0);                // next block of work
+std::mutex fmaMutex;                             // prevent threads from printing at the same time
+std::atomic<int> fmaExamples(0);                 // number of wrong results printed
+
+// test blocks of triples with all functions until all blocks are done
+void fmaThread(FmaResult * res) {
+    constexpr int vs = vtype::size();
+    Float16 * a = new Float16[fmaBlock], * b = new Float16[fmaBlock], * c = new Float16[fmaBlock];
+    Float16 * r = new Float16[fmaBlock];
+    uint8_t * xlist = new uint8_t[fmaBlock];
+    vtype av, bv, cv;
+    while (true) {
+        int block = nextFmaBlock++;              // get next block of work
+        if (block >= FMA_TRIPLES / fmaBlock) break; // finished
+        fmaTriples(block, a, b, c, xlist);
+        for (int f = 0; f < fmaNumFunctions; f++) {
+            for (int i = 0; i < fmaBlock; i += vs) {
+                av.load(a + i);  bv.load(b + i);  cv.load(c + i);
+                fmaFunction(f, av, bv, cv).store(r + i);
+            }
+            for (int i = 0; i < fmaBlock; i++) {
+                double p = double(float(a[i])) * double(float(b[i])); // exact
+                double cd = float(c[i]);
+                double s;                        // exact result
+                switch (f) {
+                case 0:  s =  p + cd;  break;
+                case 1:  s =  p - cd;  break;
+                default: s = -p + cd;  break;
+                }
+                uint16_t expected = roundToHalf(s);
+                uint16_t result = fp162half(r[i]);
+                bool tie = isHalfMidpoint(s);
+                res->ties[f] += tie;
+                if (result == expected) continue;
+                res->wrong[f]++;
+                res->tieswrong[f] += tie;
+                uint16_t viaFloat = roundToHalf(double(float(s)));  // rounded twice
+                if (result == viaFloat) res->twice[f]++;
+                if (fmaExamples < maxerrors && fmaExamples++ < maxerrors) { // lock only for printing
+                    std::lock_guard<std::mutex> lock(fmaMutex);
+                    printf("\n%s(0x%04X, 0x%04X, 0x%04X) = 0x%04X, expected 0x%04X. ", fmaNames[f], 
+                        fp162half(a[i]), fp162half(b[i]), fp162half(c[i]), result, expected);
+                    printVal(a[i]);  printf(", ");  printVal(b[i]);  printf(", ");  printVal(c[i]);
+                    printf(" -> %.10G", s);
+                }
+            }
+            res->count[f] += fmaBlock;
+        }
+    }
+    delete[] a;  delete[] b;  delete[] c;  delete[] r;  delete[] xlist;
+}
+
+volatile uint64_t fmaSink;        // prevent optimizing away the results
+
+// measure clock cycles per element of fused function f
+double fmaBenchmark(int f) {
+    constexpr int vs = vtype::size();
+    static Float16 a[fmaBlock], b[fmaBlock], c[fmaBlock], r[fmaBlock];
+    static uint8_t xlist[fmaBlock];
+    fmaTriples(0, a, b, c, xlist);
+    vtype av, bv, cv;
+    uint64_t best = ~uint64_t(0);
+    for (int rep = 0; rep < 20; rep++) {
+        uint64_t time0 = __rdtsc();
+        for (int i = 0; i < fmaBlock; i += vs) {
+            av.load(a + i);  bv.load(b + i);  cv.load(c + i);
+            fmaFunction(f, av, bv, cv).store(r + i);
+        }
+        uint64_t time1 = __rdtsc();
+        if (time1 - time0 < best) best = time1 - time0;
+    }
+    fmaSink = fp162half(r[fmaBlock - 1]);
+    return double(best) / fmaBlock;
+}
+
+// test all triples with all fused functions, distributed between nthreads threads.
+// Returns 0. Wrong results are reported as a rate, not as errors
+int fmaTest(int nthreads) {
+    if (nthreads <= 0) nthreads = std::thread::hardware_concurrency();
+    if (nthreads <= 0) nthreads = 1;
+    FmaResult * results = new FmaResult[nthreads];
+    std::thread * threads = new std::thread[nthreads];
+    auto time0 = std::chrono::steady_clock::now();
+    int t, f;
+    for (t = 0; t < nthreads; t++) threads[t] = std::thread(fmaThread, results + t);
+    for (t = 0; t < nthreads; t++) threads[t].join();
+    FmaResult sum;
+    for (t = 0; t < nthreads; t++) {
+        for (f = 0; f < fmaNumFunctions; f++) {
+            sum.count[f] += results[t].count[f];
+            sum.wrong[f] += results[t].wrong[f];
+            sum.twice[f] += results[t].twice[f];
+            sum.ties[f] += results[t].ties[f];
+            sum.tieswrong[f] += results[t].tieswrong[f];
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time0).count();
+    printf("\n\nRounding of fused multiply and add near midpoints, %s, instruction set %i, %s half precision",
+        TOSTRING(vtype), INSTRSET,
+#ifdef __AVX512FP16__
+        "native");
+#else
+        "emulated");
+#endif
+    printf("\n%.1f seconds, %i threads", seconds, nthreads);
+    printf("\nwrong: not correctly rounded. twice: wrong and equal to rounding via float. ties: exact midpoints");
+    printf("\n\n%-9s %12s %12s %12s %10s %10s %10s %10s", 
+        "function", "triples", "wrong", "twice", "twice rate", "ties", "ties wrong", "clock/elem");
+    for (f = 0; f < fmaNumFunctions; f++) {
+        printf("\n%-9s %12llu %12llu %12llu %10.3G %10llu %10llu %10.3f", fmaNames[f], 
+            (unsigned long long)sum.count[f], (unsigned long long)sum.wrong[f], 
+            (unsigned long long)sum.twice[f], double(sum.twice[f]) / double(sum.count[f]),
+            (unsigned long long)sum.ties[f], (unsigned long long)sum.tieswrong[f], fmaBenchmark(f));
+    }
+#ifdef EMULATED
+    printf("\nRunning in emulator. Clock counts are not valid");
+#endif
+    delete[] threads;
+    delete[] results;
+    return 0;
+}
+#endif  // FMA_TEST
+
 
 // program entry
-int main () {
+int main (int argc, char* argv[]) {
     vtype a, b;                   // operand vectors
     rtype result;                 // result vector
     rtype expected;               // expected result
@@ -2075,6 +3555,56 @@ int main () {
     _FPU_SETCW(fpcw);
 #endif
 
+#ifdef EXHAUSTIVE_PAIRS   // test all pairs of half precision inputs
+    uint64_t numerrors = exhaustivePairs(argc > 1 ? atoi(argv[1]) : 0);
+    numerr = numerrors > 0x7FFFFFFF ? 0x7FFFFFFF : int(numerrors);
+    if (numerr == 0) {
+        printf("\nsuccess\n");
+    }
+    printf("\n");
+    return numerr;
+#endif
+
+#ifdef CONVERSION_BENCHMARK   // throughput of conversion of arrays
+    numerr = conversionBenchmark();
+    if (numerr == 0) {
+        printf("\nsuccess\n");
+    }
+    printf("\n");
+    return numerr;
+#endif
+
+#ifdef FMA_TEST   // rounding of fused multiply and add
+    numerr = fmaTest(argc > 1 ? atoi(argv[1]) : 0);
+    printf("\n");
+    return numerr;
+#endif
+
+#ifdef MASK_TEST   // boolean results with all inputs
+    uint64_t maskerrors = maskTest(argc > 1 ? atoi(argv[1]) : 0);
+    numerr = maskerrors > 0x7FFFFFFF ? 0x7FFFFFFF : int(maskerrors);
+    if (numerr == 0) {
+        printf("\nsuccess\n");
+    }
+    printf("\n");
+    return numerr;
+#endif
+
+#ifdef SUM_TEST   // accuracy and speed of summation methods
+    numerr = sumTest();
+    printf("\n");
+    return numerr;
+#endif
+
+#ifdef ULP_TABLE   // ULP table of all mathematical functions with all inputs
+    numerr = ulpTable();
+    if (numerr == 0) {
+        printf("\nsuccess\n");
+    }
+    printf("\n");
+    return numerr;
+#endif
+
     // make lists of test data
     TestData<ST> adata, bdata;
 
@@ -2083,6 +3613,13 @@ int main () {
     // list for expected results
     RT expectedList[maxvectorsize];
 #endif
+#ifdef FLOAT_REFERENCE
+    // test data and expected results converted to float
+    static float aFloat[TestData<ST>::listsize], bFloat[TestData<ST>::listsize];
+    float expectedFloat[maxvectorsize];
+    to_float_block(adata.list, aFloat, adata.size());
+    to_float_block(bdata.list, bFloat, bdata.size());
+#endif
 
     int i, j;   // loop counters
 
@@ -2116,6 +3653,12 @@ int main () {
             // expected value to compare with
 #if defined(SCALAR_RESULT) || defined(WHOLE_VECTOR)   // result is scalar || test whole vector
             expected = rtype(referenceFunction(a, b));
+#elif defined(FLOAT_REFERENCE)   // reference calculated with float precision
+            for (int k = 0; k < vectorsize; k++) {
+                expectedFloat[k] = referenceFloat(aFloat[i + k], bFloat[j + k]);
+            }
+            to_float16_block(expectedFloat, expectedList, vectorsize);
+            loadData(expected, expectedList);
 #else       // result is vector
             for (int k = 0; k < vectorsize; k++) {
 #if defined(USE_FLAG)
@@ -2189,6 +3732,9 @@ int main () {
             }
         }
     }
+#ifdef BENCHMARK
+    benchmark(adata.list, adata.size(), bdata.list, bdata.size());
+#endif
     if (numerr == 0) {
         printf("\nsuccess\n");
     }